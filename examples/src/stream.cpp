@@ -38,6 +38,22 @@ class Stream : public capo::IStream {
 		return count;
 	}
 
+	// optional zero-copy read: the library consumes samples directly out of the buffer.
+	[[nodiscard]] auto acquire_samples(std::size_t const max_count) -> std::optional<std::span<float const>> final {
+		auto const samples = m_buffer.get_samples();
+		// cache the index the samples are acquired at.
+		m_acquired = std::min(m_index.load(), samples.size());
+		// trim front to the acquired index.
+		auto const src = samples.subspan(m_acquired);
+		// expose at most the requested number of samples.
+		return src.subspan(0, std::min(src.size(), max_count));
+	}
+
+	void release_samples(std::size_t const count) final {
+		// increment cursor unless modified via seek_to_sample() in the meanwhile.
+		m_index.compare_exchange_strong(m_acquired, m_acquired + count);
+	}
+
 	[[nodiscard]] auto get_sample_rate() const -> std::uint32_t final { return capo::Buffer::sample_rate_v; }
 	[[nodiscard]] auto get_channels() const -> std::uint8_t final { return m_buffer.get_channels(); }
 
@@ -54,6 +70,8 @@ class Stream : public capo::IStream {
 	capo::Buffer m_buffer{};
 	// the cursor index may be accessed on another thread while also being updated in read_samples().
 	std::atomic<std::size_t> m_index{};
+	// the acquired index is only used on the audio thread, between acquire and release.
+	std::size_t m_acquired{};
 };
 
 void run(fs::path const& path) {
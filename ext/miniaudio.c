@@ -0,0 +1,10 @@
+// miniaudio implementation with the bundled stb_vorbis decoder enabled.
+// The stb_vorbis header must be visible before the implementation for miniaudio to define MA_HAS_VORBIS.
+#define STB_VORBIS_HEADER_ONLY
+#include "src/miniaudio/extras/stb_vorbis.c"
+
+#define MINIAUDIO_IMPLEMENTATION
+#include "src/miniaudio/miniaudio.h"
+
+#undef STB_VORBIS_HEADER_ONLY
+#include "src/miniaudio/extras/stb_vorbis.c"
@@ -0,0 +1,56 @@
+#pragma once
+#include <capo/effect.hpp>
+#include <capo/polymorphic.hpp>
+#include <cstdint>
+#include <span>
+
+namespace capo {
+/// \brief Window applied to samples before the FFT.
+enum class FftWindow : std::int8_t { Hann, BlackmanHarris, Rectangular };
+
+/// \brief Signal levels (linear) over the most recent analysis hop, across all channels.
+struct Levels {
+	float peak{};
+	float rms{};
+};
+
+struct AnalyzerCreateInfo {
+	/// \brief FFT size in frames, rounded up to a power of 2 in [64, 16384].
+	std::uint32_t fft_size{2048};
+	/// \brief Frames between analyses, 0 for a quarter of fft_size.
+	std::uint32_t hop_size{};
+	FftWindow window{FftWindow::Hann};
+	/// \brief Exponential smoothing of magnitudes across analyses, in [0, 1).
+	float smoothing{};
+};
+
+/// \brief Real-time analysis tap: magnitude spectrum and level meters of the audio passing through it.
+/// Attach to Sources (see ISource::set_analyzer()) or the Engine's output (see IEngine::set_analyzer()).
+/// Sources attached to an Analyzer are mixed into it, and it outputs the mix (see set_output()).
+/// Channels are averaged into a ring of recent frames, which is analyzed on the audio thread once per hop.
+/// Results can be read from any thread without locks, and without ever blocking the audio thread.
+/// Must outlive all Sources (and the Engine) it is attached to.
+class IAnalyzer : public Polymorphic {
+  public:
+	[[nodiscard]] virtual auto get_fft_size() const -> std::uint32_t = 0;
+	/// \returns fft_size / 2 + 1.
+	[[nodiscard]] virtual auto get_bin_count() const -> std::uint32_t = 0;
+	/// \brief Get the center frequency of a bin in Hz.
+	[[nodiscard]] virtual auto get_bin_frequency(std::uint32_t bin) const -> float = 0;
+
+	/// \brief Copy the magnitude spectrum of the latest analysis.
+	/// Magnitudes are linear, normalized so that a full scale sine peaks at ~1 (minus window scalloping).
+	/// \param out Output bins, at most get_bin_count() are written.
+	/// \returns Number of analyses so far (out is zeroed if 0).
+	virtual auto get_spectrum(std::span<float> out) const -> std::uint64_t = 0;
+	/// \brief Get the levels of the latest analysis.
+	[[nodiscard]] virtual auto get_levels() const -> Levels = 0;
+
+	/// \brief Get the Effect the attached Sources are output to.
+	/// \returns null if outputting directly to the Engine.
+	[[nodiscard]] virtual auto get_output() const -> IEffect* = 0;
+	/// \brief Route the attached Sources to an Effect, or directly to the Engine.
+	/// \param effect Effect created by the same Engine (which must outlive this), null to output directly.
+	virtual void set_output(IEffect* effect) = 0;
+};
+} // namespace capo
@@ -0,0 +1,52 @@
+#pragma once
+#include <capo/file_system.hpp>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+
+namespace capo {
+/// \brief I/O backend of an Async File System.
+enum class IoBackend : std::int8_t { IoUring, ThreadPool };
+
+/// \brief Counters of an Async File System, since creation.
+struct IoStats {
+	/// \brief Number of reads currently in flight.
+	std::uint32_t queue_depth{};
+	/// \brief Highest number of reads in flight at once.
+	std::uint32_t max_queue_depth{};
+	/// \brief Total number of reads completed.
+	std::uint64_t reads{};
+	/// \brief Total number of bytes read.
+	std::uint64_t bytes_read{};
+	/// \brief Mean time from submission to completion of a read.
+	std::chrono::microseconds average_latency{};
+	/// \brief Longest time from submission to completion of a read.
+	std::chrono::microseconds max_latency{};
+};
+
+/// \brief File System that reads ahead of each file on a shared I/O backend.
+/// Every open file keeps the next chunk in flight while the current one is consumed,
+/// the reads of all files are batched on one capo thread (io_uring on Linux) or a worker pool.
+/// Pass to EngineCreateInfo to stream many files concurrently.
+class IAsyncFileSystem : public IFileSystem {
+  public:
+	[[nodiscard]] virtual auto get_backend() const -> IoBackend = 0;
+	[[nodiscard]] virtual auto get_stats() const -> IoStats = 0;
+};
+
+struct AsyncFileSystemCreateInfo {
+	/// \brief Size of each read-ahead chunk, two are allocated per open file.
+	std::uint32_t chunk_size{256u /*KiB*/ * 1024u /*B*/};
+	/// \brief Worker threads used by the thread pool backend.
+	std::uint32_t worker_count{2};
+	/// \brief Use io_uring if the library was built with CAPO_IO_URING and the kernel supports it.
+	bool prefer_io_uring{true};
+};
+
+/// \brief Create an Async File System over the native file system.
+/// Falls back to the thread pool backend if io_uring is not available.
+/// \param create_info Creation parameters.
+/// \returns null on failure.
+[[nodiscard]] auto create_async_file_system(AsyncFileSystemCreateInfo const& create_info = {})
+	-> std::shared_ptr<IAsyncFileSystem>;
+} // namespace capo
@@ -1,13 +1,34 @@
 #pragma once
+#include <capo/channel_layout.hpp>
+#include <capo/memory.hpp>
+#include <chrono>
 #include <cstdint>
+#include <memory_resource>
 #include <optional>
 #include <span>
 #include <string_view>
 #include <vector>
 
 namespace capo {
+class IFileSystem;
+
 /// \brief Format of encoded data.
-enum class Encoding : std::int8_t { Wav, Mp3, Flac };
+/// Opus requires capo to be built with CAPO_OPUS.
+enum class Encoding : std::int8_t { Wav, Mp3, Flac, Vorbis, Opus };
+
+/// \brief Parameters for trimming leading / trailing silence (see Buffer::trim_silence()).
+struct SilenceTrim {
+	/// \brief Frames whose samples all have a magnitude (linear) at or below this are silent.
+	float threshold{0.0001f};
+	/// \brief Silence to keep on either side of the audible frames, eg for tails that fade below threshold.
+	std::chrono::duration<float> padding{};
+};
+
+/// \brief Frames trimmed off either end of the originally set / decoded data.
+struct TrimOffsets {
+	std::uint64_t leading{};
+	std::uint64_t trailing{};
+};
 
 /// \brief Audio Buffer: stores decoded PCM data in memory.
 class Buffer {
@@ -15,20 +36,59 @@ class Buffer {
 	/// \brief Sample rate is constant (48kHz).
 	static constexpr auto sample_rate_v = 48000u;
 
-	[[nodiscard]] auto get_samples() const -> std::span<float const> { return m_samples; }
+	Buffer() = default;
+	/// \brief Allocate sample storage (and decoder scratch) from a memory resource.
+	/// As with std::pmr containers, copies of this Buffer use the default resource.
+	/// \param resource Memory resource, must outlive this instance.
+	explicit Buffer(std::pmr::memory_resource* resource) : m_samples(resource) {}
+
+	[[nodiscard]] auto get_memory_resource() const -> std::pmr::memory_resource* {
+		return m_samples.get_allocator().resource();
+	}
+
+	[[nodiscard]] auto get_samples() const -> std::span<float const> {
+		if (!m_owned_samples.empty()) { return m_owned_samples; }
+		return m_samples;
+	}
 	[[nodiscard]] auto get_channels() const -> std::uint8_t { return m_channels; }
+	/// \brief Speaker position of each channel.
+	/// \returns Default channel map for the channel count if a custom one was not set / decoded.
+	[[nodiscard]] auto get_channel_map() const -> std::span<Channel const>;
 
 	[[nodiscard]] auto get_frame_count() const -> std::uint64_t {
-		if (m_samples.empty() || m_channels == 0) { return 0; }
-		return m_samples.size() / m_channels;
+		if (m_channels == 0) { return 0; }
+		return get_samples().size() / m_channels;
 	}
 
-	[[nodiscard]] auto is_loaded() const -> bool { return m_channels > 0 && !m_samples.empty(); }
+	[[nodiscard]] auto is_loaded() const -> bool { return m_channels > 0 && !get_samples().empty(); }
 
+	/// \brief Bytes of decoded PCM (and channel map) held, charged as MemoryCategory::DecodedPcm.
+	[[nodiscard]] auto get_memory_usage() const -> std::uint64_t;
+
+	/// \brief Set custom PCM data.
+	/// Samples are copied into storage allocated from this Buffer's memory resource.
+	void set_frames(std::vector<float> const& samples, std::uint8_t channels);
+	/// \brief Set custom PCM data with a custom channel map.
+	/// Samples are copied into storage allocated from this Buffer's memory resource.
+	/// Channel count is the size of channel_map.
+	void set_frames(std::vector<float> const& samples, std::span<Channel const> channel_map);
 	/// \brief Set custom PCM data.
-	void set_frames(std::vector<float> samples, std::uint8_t channels);
+	/// Samples are moved if this Buffer uses the default (new / delete) memory resource, otherwise copied.
+	void set_frames(std::vector<float>&& samples, std::uint8_t channels);
+	/// \brief Set custom PCM data with a custom channel map.
+	/// Samples are moved if this Buffer uses the default (new / delete) memory resource, otherwise copied.
+	/// Channel count is the size of channel_map.
+	void set_frames(std::vector<float>&& samples, std::span<Channel const> channel_map);
+	/// \brief Set custom PCM data.
+	/// Samples are moved if they use the same memory resource as this Buffer, otherwise copied.
+	void set_frames(std::pmr::vector<float> samples, std::uint8_t channels);
+	/// \brief Set custom PCM data with a custom channel map.
+	/// Samples are moved if they use the same memory resource as this Buffer, otherwise copied.
+	/// Channel count is the size of channel_map.
+	void set_frames(std::pmr::vector<float> samples, std::span<Channel const> channel_map);
 
 	/// \brief Decode bytes in memory.
+	/// Fails if the decoded PCM would exceed the memory budget (see set_memory_budget()).
 	/// \param bytes Encoded bytes.
 	/// \param encoding Encoding format, if known.
 	/// \returns true on success.
@@ -40,9 +100,34 @@ class Buffer {
 	/// \returns true on success.
 	[[nodiscard]] auto decode_file(char const* path, std::optional<Encoding> encoding = {}) -> bool;
 
+	/// \brief Decode an audio file via a custom File System.
+	/// Files that expose their contents in memory are decoded without copying.
+	/// \param file_system File System to open path with.
+	/// \param path Path to audio file.
+	/// \param encoding Encoding format, if known.
+	/// \returns true on success.
+	[[nodiscard]] auto decode_file(IFileSystem& file_system, char const* path, std::optional<Encoding> encoding = {})
+		-> bool;
+
+	/// \brief Trim leading and trailing silence (eg encoder padding), and shrink storage to fit.
+	/// Typically called right after decoding. Buffers that are entirely silent are left untouched.
+	/// Trimmed frames are accumulated into get_trim_offsets(), which are reset when frames are set / decoded.
+	/// Existing BufferViews keep their frame ranges (now offset by the leading trim): trim before creating views.
+	/// \param params Trim parameters.
+	/// \returns Number of frames trimmed.
+	auto trim_silence(SilenceTrim const& params = {}) -> std::uint64_t;
+	/// \brief Get the frames trimmed off either end.
+	/// Add the leading offset to a position in this Buffer (eg a Source's cursor) to map it to the original data.
+	[[nodiscard]] auto get_trim_offsets() const -> TrimOffsets { return m_trim; }
+
   private:
-	std::vector<float> m_samples{};
+	std::pmr::vector<float> m_samples{};
+	// samples moved in by set_frames(std::vector&&), take precedence over m_samples when not empty.
+	std::vector<float> m_owned_samples{};
+	std::vector<Channel> m_channel_map{};
 	std::uint8_t m_channels{};
+	TrimOffsets m_trim{};
+	MemoryCharge m_charge{MemoryCategory::DecodedPcm, 0};
 };
 
 /// \brief Guess the Encoding format based on the file extension.
@@ -0,0 +1,48 @@
+#pragma once
+#include <capo/buffer.hpp>
+#include <cstdint>
+#include <memory>
+#include <span>
+
+namespace capo {
+/// \brief View of a range of frames in a shared Audio Buffer.
+/// Enables packing many short sounds into one Buffer (atlas): one allocation, one decode.
+/// Cheap to copy, samples are never copied. Holds a reference to the Buffer.
+class BufferView {
+  public:
+	/// \brief Frame count sentinel for "until the end of the Buffer".
+	static constexpr auto all_frames_v = ~std::uint64_t{};
+
+	BufferView() = default;
+
+	/// \brief Construct a view of a range of frames, clamped to the Buffer.
+	/// \param buffer Buffer to view.
+	/// \param first_frame Index of first frame in view.
+	/// \param frame_count Number of frames in view.
+	explicit BufferView(std::shared_ptr<Buffer const> buffer, std::uint64_t first_frame = 0,
+						std::uint64_t frame_count = all_frames_v);
+
+	[[nodiscard]] auto get_buffer() const -> std::shared_ptr<Buffer const> const& { return m_buffer; }
+	[[nodiscard]] auto get_first_frame() const -> std::uint64_t { return m_first_frame; }
+	[[nodiscard]] auto get_frame_count() const -> std::uint64_t { return m_frame_count; }
+	[[nodiscard]] auto get_channels() const -> std::uint8_t { return m_buffer ? m_buffer->get_channels() : 0; }
+	[[nodiscard]] auto get_channel_map() const -> std::span<Channel const>;
+
+	/// \brief Get the samples in view, pointing into the Buffer.
+	/// The range is not adjusted if the Buffer is modified afterwards (eg trimmed), only clamped to its frames.
+	[[nodiscard]] auto get_samples() const -> std::span<float const>;
+
+	[[nodiscard]] auto is_loaded() const -> bool { return m_frame_count > 0; }
+
+	/// \brief Get a view of a range of frames relative to this view, clamped to it.
+	/// \param first_frame Index of first frame, relative to this view.
+	/// \param frame_count Number of frames in view.
+	[[nodiscard]] auto get_subview(std::uint64_t first_frame, std::uint64_t frame_count = all_frames_v) const
+		-> BufferView;
+
+  private:
+	std::shared_ptr<Buffer const> m_buffer{};
+	std::uint64_t m_first_frame{};
+	std::uint64_t m_frame_count{};
+};
+} // namespace capo
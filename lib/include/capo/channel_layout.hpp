@@ -0,0 +1,28 @@
+#pragma once
+#include <cstdint>
+#include <span>
+
+namespace capo {
+/// \brief Speaker position of an interleaved channel.
+enum class Channel : std::int8_t {
+	None,
+	Mono,
+	FrontLeft,
+	FrontRight,
+	FrontCenter,
+	Lfe,
+	BackLeft,
+	BackRight,
+	FrontLeftCenter,
+	FrontRightCenter,
+	BackCenter,
+	SideLeft,
+	SideRight,
+};
+
+/// \brief Get the default channel map for a channel count.
+/// Follows the WAVE / Microsoft ordering, eg 5.1 is FL FR FC LFE SL SR and 7.1 is FL FR FC LFE BL BR SL SR.
+/// \param channels Channel count.
+/// \returns Empty span if channels is 0 or greater than 8.
+[[nodiscard]] auto get_default_channel_map(std::uint8_t channels) -> std::span<Channel const>;
+} // namespace capo
@@ -0,0 +1,43 @@
+#pragma once
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+
+namespace capo {
+/// \brief Snapshot of a playback position, for synchronizing with the audio output (eg video, visualizers).
+/// Positions only advance once per audio callback: the audible position is interpolated in between,
+/// and compensated for output latency.
+struct PlaybackClock {
+	using clock_t = std::chrono::steady_clock;
+
+	/// \brief Position in frames, as of the last audio callback.
+	std::uint64_t frames{};
+	/// \brief Sample rate of frames.
+	std::uint32_t sample_rate{};
+	/// \brief Frames advanced per frame of real time (eg pitch), 0 if not playing.
+	float rate{};
+	/// \brief Time at which the last audio callback was processed.
+	clock_t::time_point callback_time{};
+	/// \brief Output latency: time between a frame being mixed and it being audible.
+	std::chrono::duration<double> latency{};
+
+	/// \brief Get the frame currently being heard.
+	/// \param now Time to interpolate to.
+	/// \returns Interpolated position minus latency, clamped to [0, frames].
+	[[nodiscard]] auto get_audible_frame(clock_t::time_point const now = clock_t::now()) const -> double {
+		if (sample_rate == 0) { return 0.0; }
+		auto const elapsed = std::chrono::duration<double>{now - callback_time} - latency;
+		auto const ret = double(frames) + (elapsed.count() * double(sample_rate) * double(rate));
+		return std::clamp(ret, 0.0, double(frames));
+	}
+
+	/// \brief Get the position currently being heard.
+	/// \param now Time to interpolate to.
+	/// \returns Interpolated position minus latency, clamped to [0, frames].
+	[[nodiscard]] auto get_audible_position(clock_t::time_point const now = clock_t::now()) const
+		-> std::chrono::duration<double> {
+		if (sample_rate == 0) { return {}; }
+		return std::chrono::duration<double>{get_audible_frame(now) / double(sample_rate)};
+	}
+};
+} // namespace capo
@@ -0,0 +1,83 @@
+#pragma once
+#include <capo/polymorphic.hpp>
+#include <chrono>
+#include <cstdint>
+#include <variant>
+
+namespace capo {
+namespace effect {
+/// \brief Butterworth low-pass filter.
+struct LowPass {
+	/// \brief Cutoff frequency in Hz.
+	float cutoff{1000.0f};
+	/// \brief Filter order, [1, 8].
+	std::uint8_t order{2};
+};
+
+/// \brief Butterworth high-pass filter.
+struct HighPass {
+	/// \brief Cutoff frequency in Hz.
+	float cutoff{200.0f};
+	/// \brief Filter order, [1, 8].
+	std::uint8_t order{2};
+};
+
+/// \brief Generic biquad filter, specified by its (un-normalized) coefficients.
+/// Defaults to pass-through.
+struct Biquad {
+	float b0{1.0f};
+	float b1{0.0f};
+	float b2{0.0f};
+	float a0{1.0f};
+	float a1{0.0f};
+	float a2{0.0f};
+};
+
+/// \brief Feedback delay (echo).
+struct Delay {
+	/// \brief Delay length, fixed at creation.
+	std::chrono::duration<float> delay{0.25f};
+	/// \brief Feedback gain, [0, 1).
+	float decay{0.5f};
+	float wet{1.0f};
+	float dry{1.0f};
+};
+
+/// \brief Freeverb style reverb.
+/// Only supported by Engines with mono or stereo output.
+struct Reverb {
+	float room_size{0.5f};
+	float damping{0.25f};
+	float width{1.0f};
+	float wet{1.0f / 3.0f};
+	float dry{0.0f};
+};
+} // namespace effect
+
+/// \brief Type and parameters of an Effect.
+using EffectDesc = std::variant<effect::LowPass, effect::HighPass, effect::Biquad, effect::Delay, effect::Reverb>;
+
+/// \brief Audio Effect.
+/// Node in the Engine's effect graph that any number of Sources (and other Effects) can output to.
+/// Inputs are mixed first, so each Effect is processed once per block regardless of how many are routed to it.
+/// Must outlive all Sources and Effects routed to it.
+class IEffect : public Polymorphic {
+  public:
+	[[nodiscard]] virtual auto get_desc() const -> EffectDesc const& = 0;
+	/// \brief Update parameters.
+	/// \param desc New parameters, must be of the same type. Filter order and delay length cannot be changed.
+	/// \returns false if parameters could not be applied.
+	virtual auto set_desc(EffectDesc const& desc) -> bool = 0;
+
+	[[nodiscard]] virtual auto get_gain() const -> float = 0;
+	virtual void set_gain(float gain) = 0;
+
+	/// \brief Get the Effect this outputs to.
+	/// \returns null if outputting directly to the Engine.
+	[[nodiscard]] virtual auto get_output() const -> IEffect* = 0;
+	/// \brief Route output to another Effect (chaining), or directly to the Engine.
+	/// \param effect Effect created by the same Engine, null to output directly.
+	/// \returns false if routing would create a cycle.
+	virtual auto set_output(IEffect* effect) -> bool = 0;
+};
+} // namespace capo
@@ -1,9 +1,50 @@
 #pragma once
+#include <capo/analyzer.hpp>
 #include <capo/build_version.hpp>
+#include <capo/effect.hpp>
+#include <capo/file_system.hpp>
+#include <capo/oneshot.hpp>
+#include <capo/output_capture.hpp>
 #include <capo/source.hpp>
+#include <chrono>
+#include <cstdint>
 #include <memory>
+#include <memory_resource>
 
 namespace capo {
+/// \brief When an Engine's output device is initialized and started.
+enum class DeviceStart : std::int8_t {
+	/// \brief Within create_engine(), which fails if the device cannot be started.
+	/// One-shot voices are initialized right after the device starts.
+	Immediate,
+	/// \brief On a background thread, right after create_engine() returns.
+	Async,
+	/// \brief On a background thread, once any Source or one-shot is first played.
+	OnFirstPlay,
+};
+
+/// \brief State of an Engine's output device.
+enum class DeviceState : std::int8_t { Pending, Started, Failed };
+
+/// \brief Durations of the phases of Engine startup.
+struct StartupTimings {
+	/// \brief Resource manager initialization (starts its job thread).
+	std::chrono::duration<float> resource_manager{};
+	/// \brief Engine initialization, including the backend and device if started immediately.
+	std::chrono::duration<float> engine_init{};
+	/// \brief Backend and device initialization, if started lazily.
+	std::chrono::duration<float> device_init{};
+	/// \brief Starting the device.
+	std::chrono::duration<float> device_start{};
+	/// \brief Initializing one-shot voices ahead of first use, once the device has started.
+	std::chrono::duration<float> voice_warmup{};
+	/// \brief Time spent blocked in create_engine().
+	std::chrono::duration<float> create_engine{};
+	/// \brief Time from calling create_engine() until the device started (or failed to).
+	std::chrono::duration<float> until_started{};
+	DeviceState device{DeviceState::Pending};
+};
+
 /// \brief Audio Engine.
 /// API to create Audio Sources.
 /// Represents 3D spatialized listener.
@@ -13,6 +54,77 @@ class IEngine : public Polymorphic {
 	/// \brief Create an Audio Source.
 	/// \returns null on failure.
 	[[nodiscard]] virtual auto create_source() -> std::unique_ptr<ISource> = 0;
+	/// \brief Create an Audio Source that can be driven from any thread without locks.
+	/// Calls are recorded into a lock-free MPSC command queue and applied in order on a capo-owned thread.
+	/// Binds return true once queued; getters return the last requested / published state.
+	/// Destruction blocks until its queued commands have been applied, after which bound data can be destroyed.
+	/// \returns null on failure.
+	[[nodiscard]] virtual auto create_async_source() -> std::unique_ptr<ISource> = 0;
+	/// \brief Create an Effect, initially outputting directly to the Engine.
+	/// Route Sources to it via ISource::set_output().
+	/// \param desc Type and parameters of Effect.
+	/// \returns null on failure.
+	[[nodiscard]] virtual auto create_effect(EffectDesc const& desc) -> std::unique_ptr<IEffect> = 0;
+	/// \brief Create an Analyzer, initially detached.
+	/// Attach to Sources via ISource::set_analyzer(), or to the Engine's output via set_analyzer().
+	/// \param create_info Analysis parameters.
+	/// \returns null on failure.
+	[[nodiscard]] virtual auto create_analyzer(AnalyzerCreateInfo const& create_info = {})
+		-> std::unique_ptr<IAnalyzer> = 0;
+	/// \brief Create a MixGroup, initially outputting directly to the Engine.
+	/// Route Sources to it via ISource::set_mix_group().
+	/// Starts the Engine's mixing threads (see EngineCreateInfo) on first use.
+	/// \returns null on failure, or if the maximum number of groups (64) exist.
+	[[nodiscard]] virtual auto create_mix_group() -> std::unique_ptr<IMixGroup> = 0;
+	/// \brief Block until all commands queued by async Sources so far have been applied.
+	virtual void wait_idle() = 0;
+
+	/// \brief Play a Buffer once, without a Source (fire and forget).
+	/// Plays on a voice from a fixed pool (see EngineCreateInfo), which is recycled at the end of playback.
+	/// If all voices are busy one is stolen as per the steal policy.
+	/// Voices are initialized for the channel layout they play: once warm, this does not allocate.
+	/// Passed buffer must outlive its playback. Thread-safe.
+	/// \param buffer Audio Buffer to play.
+	/// \param params Playback parameters.
+	/// \returns false if buffer is not loaded, or no voice could be obtained.
+	virtual auto play_oneshot(Buffer const& buffer, OneShotParams const& params = {}) -> bool = 0;
+	/// \brief Get the number of voices currently playing one-shots.
+	[[nodiscard]] virtual auto get_active_oneshots() const -> std::uint32_t = 0;
+	/// \brief Stop all one-shots.
+	virtual void stop_oneshots() = 0;
+
+	/// \brief Get the clock of the Engine's output: frames mixed since it started.
+	[[nodiscard]] virtual auto get_clock() const -> PlaybackClock = 0;
+
+	/// \brief Get the durations of startup phases so far, and the state of the device. Thread-safe.
+	[[nodiscard]] virtual auto get_startup_timings() const -> StartupTimings = 0;
+
+	/// \brief Get the Analyzer of the Engine's (final mixed) output.
+	/// \returns null if not analyzed.
+	[[nodiscard]] virtual auto get_analyzer() const -> IAnalyzer* = 0;
+	/// \brief Analyze the Engine's final mixed output. Thread-safe.
+	/// An Analyzer must not be attached to both Sources and the Engine's output.
+	/// When replacing / detaching, returns once the audio thread is done with the previous Analyzer.
+	/// \param analyzer Analyzer created by this Engine, null to stop analyzing.
+	virtual void set_analyzer(IAnalyzer* analyzer) = 0;
+
+	/// \brief Create a capture of the Engine's final mixed output, in its output format.
+	/// Attach via set_output_capture().
+	/// \param create_info Capture parameters.
+	/// \returns null on failure.
+	[[nodiscard]] virtual auto create_output_capture(OutputCaptureCreateInfo const& create_info = {})
+		-> std::unique_ptr<IOutputCapture> = 0;
+	/// \brief Get the OutputCapture being written to.
+	/// \returns null if not capturing.
+	[[nodiscard]] virtual auto get_output_capture() const -> IOutputCapture* = 0;
+	/// \brief Start / stop copying the Engine's final mixed output into an OutputCapture. Thread-safe.
+	/// When replacing / detaching, returns once the audio thread is done with the previous OutputCapture.
+	/// \param capture OutputCapture created by this Engine, null to stop capturing.
+	virtual void set_output_capture(IOutputCapture* capture) = 0;
+
+	/// \brief Bytes currently allocated by this Engine's miniaudio instance.
+	/// Includes sounds, effects, and pages of file streams, but not Buffers (see get_memory_stats()).
+	[[nodiscard]] virtual auto get_memory_usage() const -> std::uint64_t = 0;
 
 	/// \brief Obtain the listener's 3D position.
 	[[nodiscard]] virtual auto get_position() const -> Vec3f = 0;
@@ -30,7 +142,31 @@ class IEngine : public Polymorphic {
 	virtual void set_world_up(Vec3f const& direction) = 0;
 };
 
+/// \brief Engine creation parameters.
+struct EngineCreateInfo {
+	/// \brief File System that file streams are opened with, null for the native one.
+	std::shared_ptr<IFileSystem> file_system{};
+	/// \brief Memory resource that all of the Engine's miniaudio allocations are made from, null for malloc.
+	/// Must be thread-safe (eg std::pmr::synchronized_pool_resource) and outlive the Engine.
+	std::pmr::memory_resource* memory_resource{};
+	/// \brief Number of voices per channel layout that one-shots are played on (see IEngine::play_oneshot()).
+	/// Mono and stereo voices are initialized at startup, voices of other layouts on first use.
+	/// Voices are never reinitialized, a one-shot only steals voices of its own layout.
+	std::uint32_t oneshot_voices{32};
+	/// \brief Voice to steal when a one-shot is played while all voices are busy.
+	StealPolicy oneshot_steal{StealPolicy::Oldest};
+	/// \brief Number of threads that mix groups (see IEngine::create_mix_group()), 0 for hardware concurrency - 1.
+	std::uint32_t mix_threads{};
+	/// \brief When to initialize and start the output device.
+	/// When lazy, create_engine() returns without touching the backend: Sources can be created, bound and played
+	/// right away, and start (from their beginning) once the device comes up. One-shot voices are initialized on the
+	/// background thread, after the device starts. The Engine mixes in stereo at Buffer::sample_rate_v, the device
+	/// converts to its native format if required.
+	DeviceStart device_start{DeviceStart::Immediate};
+};
+
 /// \brief Create an Engine instance.
+/// \param create_info Creation parameters.
 /// \returns null on failure.
-[[nodiscard]] auto create_engine() -> std::unique_ptr<IEngine>;
+[[nodiscard]] auto create_engine(EngineCreateInfo const& create_info = {}) -> std::unique_ptr<IEngine>;
 } // namespace capo
@@ -0,0 +1,49 @@
+#pragma once
+#include <capo/polymorphic.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <vector>
+
+namespace capo {
+enum class SeekOrigin : std::int8_t { Begin, Current, End };
+
+/// \brief Read-only file opened via a File System.
+/// Only used by one thread at a time.
+class IFile : public Polymorphic {
+  public:
+	/// \returns Count of bytes read, 0 if at end (or on failure, see has_failed()).
+	[[nodiscard]] virtual auto read(std::span<std::byte> out) -> std::size_t = 0;
+	/// \returns false on failure.
+	[[nodiscard]] virtual auto seek(std::int64_t offset, SeekOrigin origin) -> bool = 0;
+	/// \returns Current read position in bytes.
+	[[nodiscard]] virtual auto tell() const -> std::uint64_t = 0;
+	/// \returns Total size in bytes.
+	[[nodiscard]] virtual auto get_size() const -> std::uint64_t = 0;
+
+	/// \brief Optional: entire contents already in memory (eg inside a memory mapped archive).
+	/// Enables decoding Buffers directly out of it, without reading / copying.
+	/// \returns Empty span if not supported.
+	[[nodiscard]] virtual auto get_contents() const -> std::span<std::byte const> { return {}; }
+
+	/// \brief Optional: whether a read failed (I/O error), as opposed to reaching the end.
+	[[nodiscard]] virtual auto has_failed() const -> bool { return false; }
+};
+
+/// \brief Interface for custom file access, eg streaming out of packed archives.
+/// Used by file streams (see EngineCreateInfo) and Buffer decoding.
+/// Must be safe to call from any thread: file streams are opened and read on the resource manager's thread.
+class IFileSystem : public Polymorphic {
+  public:
+	/// \param path Path to file.
+	/// \returns null if file could not be opened.
+	[[nodiscard]] virtual auto open(char const* path) -> std::unique_ptr<IFile> = 0;
+};
+
+/// \brief Get the native (OS) File System.
+[[nodiscard]] auto get_native_file_system() -> IFileSystem&;
+
+/// \brief Load file data as a binary byte array via a File System.
+[[nodiscard]] auto file_to_bytes(IFileSystem& file_system, char const* path) -> std::vector<std::byte>;
+} // namespace capo
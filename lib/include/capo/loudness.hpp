@@ -0,0 +1,82 @@
+#pragma once
+#include <capo/buffer.hpp>
+#include <capo/polymorphic.hpp>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <span>
+#include <vector>
+
+namespace capo {
+/// \brief Loudness measurement as per EBU R128 / ITU-R BS.1770-4.
+/// All values are -infinity for silent input.
+struct Loudness {
+	/// \brief Gated integrated loudness in LUFS.
+	float integrated{};
+	/// \brief Loudness range (LRA) in LU.
+	float range{};
+	/// \brief 4x oversampled true peak in dBTP.
+	float true_peak{};
+	/// \brief Sample peak in dBFS.
+	float sample_peak{};
+};
+
+/// \brief Streaming loudness meter.
+/// Only stores per-block energies (not PCM), suitable for inputs of any length.
+class ILoudnessMeter : public Polymorphic {
+  public:
+	[[nodiscard]] virtual auto get_channels() const -> std::uint8_t = 0;
+	[[nodiscard]] virtual auto get_sample_rate() const -> std::uint32_t = 0;
+
+	/// \brief Measure interleaved samples.
+	/// \param samples Interleaved samples, size must be a multiple of channel count.
+	virtual void push_samples(std::span<float const> samples) = 0;
+
+	/// \brief Compute loudness of all samples pushed so far.
+	[[nodiscard]] virtual auto get_loudness() const -> Loudness = 0;
+};
+
+/// \brief Create a Loudness Meter.
+/// \param channels Channel count (interleaved), assumed to be in the default channel map's order.
+/// \param sample_rate Sample rate of input.
+/// \returns null if channels or sample_rate is 0.
+[[nodiscard]] auto create_loudness_meter(std::uint8_t channels, std::uint32_t sample_rate = Buffer::sample_rate_v)
+	-> std::unique_ptr<ILoudnessMeter>;
+
+/// \brief Create a Loudness Meter for a channel layout.
+/// Channels are weighted by position: LFE is excluded, side and back surrounds are weighted +1.5dB.
+/// \param channel_map Speaker position of each interleaved channel.
+/// \param sample_rate Sample rate of input.
+/// \returns null if channel_map is empty or sample_rate is 0.
+[[nodiscard]] auto create_loudness_meter(std::span<Channel const> channel_map,
+										 std::uint32_t sample_rate = Buffer::sample_rate_v)
+	-> std::unique_ptr<ILoudnessMeter>;
+
+/// \brief Measure loudness of decoded PCM.
+/// \returns nullopt if buffer is not loaded.
+[[nodiscard]] auto measure_loudness(Buffer const& buffer) -> std::optional<Loudness>;
+
+/// \brief Measure loudness of an audio file by streaming it through a decoder.
+/// The file is decoded in chunks at its native sample rate, the full PCM is never held in memory.
+/// \param path Path to audio file.
+/// \param encoding Encoding format, if known.
+/// \returns nullopt on failure.
+[[nodiscard]] auto measure_loudness_file(char const* path, std::optional<Encoding> encoding = {})
+	-> std::optional<Loudness>;
+
+/// \brief Measure loudness of multiple audio files in parallel.
+/// \param paths Paths to audio files.
+/// \param thread_count Number of worker threads, 0 for hardware concurrency.
+/// \returns Result per path, in the same order.
+[[nodiscard]] auto measure_loudness_files(std::span<char const* const> paths, std::uint32_t thread_count = 0)
+	-> std::vector<std::optional<Loudness>>;
+
+/// \brief Compute linear gain to normalize measured loudness to a target.
+/// The gain is reduced if required to keep the true peak below the ceiling.
+/// \param loudness Measured loudness.
+/// \param target_lufs Target integrated loudness (EBU R128 uses -23 LUFS).
+/// \param true_peak_ceiling Maximum allowed true peak in dBTP.
+/// \returns Linear gain, 1.0 if loudness is not finite.
+[[nodiscard]] auto get_normalization_gain(Loudness const& loudness, float target_lufs = -23.0f,
+										  float true_peak_ceiling = -1.0f) -> float;
+} // namespace capo
@@ -0,0 +1,93 @@
+#pragma once
+#include <capo/polymorphic.hpp>
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <optional>
+
+namespace capo {
+/// \brief Kind of memory tracked by capo.
+enum class MemoryCategory : std::int8_t {
+	/// \brief Decoded PCM held by Buffers.
+	DecodedPcm,
+	/// \brief Encoded bytes held while decoding.
+	EncodedData,
+	/// \brief Stream pipe and read-ahead buffers.
+	StreamBuffers,
+	/// \brief Allocations by miniaudio (engines, sounds, file streams, decoders).
+	Miniaudio,
+};
+
+inline constexpr auto memory_category_count_v = std::size_t(MemoryCategory::Miniaudio) + 1;
+
+/// \brief Process-wide memory statistics.
+struct MemoryStats {
+	/// \brief Bytes currently held, indexed by MemoryCategory.
+	std::array<std::uint64_t, memory_category_count_v> bytes{};
+	/// \brief Sum of bytes.
+	std::uint64_t total{};
+	/// \brief Highest total so far.
+	std::uint64_t peak{};
+	/// \brief Budget in bytes, 0 if unlimited.
+	std::uint64_t budget{};
+
+	[[nodiscard]] auto get(MemoryCategory const category) const -> std::uint64_t {
+		return bytes.at(std::size_t(category));
+	}
+};
+
+/// \brief Releases memory on demand, when a load would exceed the budget.
+class IMemoryEvictor : public Polymorphic {
+  public:
+	/// \brief Release memory, eg by dropping cached Buffers.
+	/// Called on the thread that is loading, must not load anything itself.
+	/// \param required Bytes that need to be released for the load to succeed.
+	/// \returns false if nothing (more) can be released.
+	virtual auto evict(std::uint64_t required) -> bool = 0;
+};
+
+/// \brief Memory budget.
+/// Decoding Buffers fails if it would exceed the budget even after eviction.
+/// Miniaudio allocations and Buffer::set_frames() are counted but never fail.
+struct MemoryBudget {
+	/// \brief Maximum bytes, 0 for unlimited.
+	std::uint64_t max_bytes{};
+	/// \brief Called when a load would exceed max_bytes, optional.
+	std::shared_ptr<IMemoryEvictor> evictor{};
+};
+
+/// \brief RAII charge of bytes against a MemoryCategory.
+/// Copies charge the same bytes again, moves transfer the charge.
+class MemoryCharge {
+  public:
+	/// \brief Charge bytes if they fit in the budget, evicting if required.
+	/// \returns nullopt if the budget would still be exceeded.
+	[[nodiscard]] static auto try_create(MemoryCategory category, std::uint64_t bytes) -> std::optional<MemoryCharge>;
+
+	MemoryCharge() = default;
+	/// \brief Charge bytes unconditionally.
+	explicit MemoryCharge(MemoryCategory category, std::uint64_t bytes);
+
+	MemoryCharge(MemoryCharge const& rhs);
+	MemoryCharge(MemoryCharge&& rhs) noexcept;
+	auto operator=(MemoryCharge const& rhs) -> MemoryCharge&;
+	auto operator=(MemoryCharge&& rhs) noexcept -> MemoryCharge&;
+	~MemoryCharge();
+
+	[[nodiscard]] auto get_category() const -> MemoryCategory { return m_category; }
+	[[nodiscard]] auto get_bytes() const -> std::uint64_t { return m_bytes; }
+
+	/// \brief Change the charged byte count unconditionally.
+	void resize(std::uint64_t bytes);
+
+  private:
+	MemoryCategory m_category{};
+	std::uint64_t m_bytes{};
+};
+
+/// \brief Obtain process-wide memory statistics.
+[[nodiscard]] auto get_memory_stats() -> MemoryStats;
+
+/// \brief Set the process-wide memory budget.
+void set_memory_budget(MemoryBudget budget);
+} // namespace capo
@@ -0,0 +1,30 @@
+#pragma once
+#include <capo/effect.hpp>
+#include <capo/polymorphic.hpp>
+#include <cstdint>
+
+namespace capo {
+/// \brief Group of Sources that is mixed in parallel with other groups, on the Engine's mixing threads.
+/// Each group is mixed into a private node graph one audio callback ahead, by whichever worker gets to it first.
+/// The audio thread then only sums the pre-mixed blocks, so voice count scales with cores instead of being capped
+/// by the audio thread. If a block is not ready in time (an underrun), the audio thread mixes it itself, unless a
+/// worker is already mixing it: the audio thread never waits on workers, so the missing part is then silent.
+/// Grouped Sources are heard one callback later (their clocks are compensated), and bypass their own output Effect
+/// and Analyzer: route the group instead.
+/// Must outlive all Sources routed to it, and be destroyed before the Engine.
+class IMixGroup : public Polymorphic {
+  public:
+	[[nodiscard]] virtual auto get_gain() const -> float = 0;
+	virtual void set_gain(float gain) = 0;
+
+	/// \brief Get the Effect this outputs to.
+	/// \returns null if outputting directly to the Engine.
+	[[nodiscard]] virtual auto get_output() const -> IEffect* = 0;
+	/// \brief Route output through an Effect, or directly to the Engine.
+	/// \param effect Effect created by the same Engine, null to output directly.
+	virtual void set_output(IEffect* effect) = 0;
+
+	/// \brief Number of blocks that were not ready in time, because workers were late.
+	[[nodiscard]] virtual auto get_underrun_count() const -> std::uint64_t = 0;
+};
+} // namespace capo
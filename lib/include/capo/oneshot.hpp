@@ -0,0 +1,30 @@
+#pragma once
+#include <capo/effect.hpp>
+#include <capo/vec3.hpp>
+#include <cstdint>
+
+namespace capo {
+/// \brief Voice to steal when a one-shot is played while all voices are busy.
+/// Voices of lower priority are always stolen first.
+enum class StealPolicy : std::int8_t {
+	/// \brief Steal the voice that started playing earliest.
+	Oldest,
+	/// \brief Steal the voice with the lowest gain.
+	Quietest,
+	/// \brief Never steal: the new one-shot is dropped.
+	None,
+};
+
+/// \brief Parameters of a one-shot (see IEngine::play_oneshot()).
+struct OneShotParams {
+	Vec3f position{};
+	float gain{1.0f};
+	float pan{0.0f};
+	float pitch{1.0f};
+	bool spatialized{true};
+	/// \brief Effect to output to, null to output directly to the Engine.
+	IEffect* output{};
+	/// \brief Voices playing one-shots of higher priority are never stolen.
+	std::int32_t priority{};
+};
+} // namespace capo
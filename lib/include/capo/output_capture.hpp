@@ -0,0 +1,31 @@
+#pragma once
+#include <capo/stream.hpp>
+#include <chrono>
+#include <cstdint>
+
+namespace capo {
+struct OutputCaptureCreateInfo {
+	/// \brief Duration of output that can be buffered before frames are dropped.
+	std::chrono::milliseconds capacity{500};
+};
+
+/// \brief Reader of the Engine's final mixed output (see IEngine::set_output_capture()).
+/// Each audio callback copies its frames into a lock-free single-producer single-consumer ring,
+/// frames that do not fit (reader too slow) are dropped and counted.
+/// Reads never block: read_samples() returns 0 when nothing is available (not at end).
+/// Must be read from one thread at a time, and must not be bound to a Source of the same Engine.
+/// Must outlive the Engine, or be detached first (set_output_capture() returns once the audio thread is done with it).
+class IOutputCapture : public IStream {
+  public:
+	/// \brief Number of samples (whole frames) that can be read right now.
+	[[nodiscard]] virtual auto get_available_samples() const -> std::size_t = 0;
+	/// \brief Total number of frames captured (including dropped ones).
+	[[nodiscard]] virtual auto get_captured_frames() const -> std::uint64_t = 0;
+	/// \brief Total number of frames dropped because the ring was full.
+	[[nodiscard]] virtual auto get_dropped_frames() const -> std::uint64_t = 0;
+	/// \brief Number of callbacks that dropped frames.
+	[[nodiscard]] virtual auto get_overflow_count() const -> std::uint64_t = 0;
+	/// \brief Discard all unread samples.
+	virtual void clear() = 0;
+};
+} // namespace capo
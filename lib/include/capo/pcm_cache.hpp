@@ -0,0 +1,62 @@
+#pragma once
+#include <capo/buffer.hpp>
+#include <capo/polymorphic.hpp>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+
+namespace capo {
+/// \brief Counters of a PCM Cache, since creation.
+struct PcmCacheStats {
+	/// \brief Loads served from the cache.
+	std::uint64_t hits{};
+	/// \brief Loads that had to decode (and were then stored).
+	std::uint64_t misses{};
+	/// \brief Entries dropped because their source file changed.
+	std::uint64_t invalidations{};
+	/// \brief Entries deleted to stay within the size limit.
+	std::uint64_t evictions{};
+	/// \brief Current number of entries.
+	std::uint64_t entry_count{};
+	/// \brief Current total size of entries on disk.
+	std::uint64_t size_bytes{};
+};
+
+/// \brief Persistent on-disk cache of decoded PCM.
+/// Entries are keyed by absolute path, and validated against the source file's
+/// modification time and size (falling back to a content hash if those changed).
+/// PCM is stored raw (f32, 64-byte aligned) at Buffer::sample_rate_v: cache hits do not decode.
+/// Entries are memory-mapped (where supported) and their PCM copied into the Buffer's storage on load.
+/// All member functions are thread-safe.
+class IPcmCache : public Polymorphic {
+  public:
+	[[nodiscard]] virtual auto get_directory() const -> std::string const& = 0;
+	[[nodiscard]] virtual auto get_stats() const -> PcmCacheStats = 0;
+
+	/// \brief Load an audio file into a Buffer, via the cache.
+	/// On a miss the file is decoded as per Buffer::decode_file() and then stored.
+	/// \param out Buffer to load into.
+	/// \param path Path to audio file.
+	/// \param encoding Encoding format, if known.
+	/// \returns true on success.
+	[[nodiscard]] virtual auto load(Buffer& out, char const* path, std::optional<Encoding> encoding = {}) -> bool = 0;
+
+	/// \brief Delete the entry for a file, if any.
+	virtual void invalidate(char const* path) = 0;
+	/// \brief Delete all entries.
+	virtual void clear() = 0;
+};
+
+struct PcmCacheCreateInfo {
+	/// \brief Directory to store entries in, created if it doesn't exist.
+	std::string directory{};
+	/// \brief Maximum total size of entries, least recently used entries are deleted to stay within it.
+	std::uint64_t max_bytes{1024ull /*MiB*/ * 1024ull /*KiB*/ * 1024ull /*B*/};
+};
+
+/// \brief Create a PCM Cache.
+/// \param create_info Creation parameters.
+/// \returns null if directory is empty or could not be created.
+[[nodiscard]] auto create_pcm_cache(PcmCacheCreateInfo create_info) -> std::unique_ptr<IPcmCache>;
+} // namespace capo
@@ -0,0 +1,48 @@
+#pragma once
+#include <capo/buffer.hpp>
+#include <chrono>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <vector>
+
+namespace capo {
+/// \brief Metadata of encoded audio, obtained without decoding any PCM.
+struct AudioInfo {
+	Encoding encoding{};
+	std::uint8_t channels{};
+	/// \brief Native sample rate (before any resampling to Buffer::sample_rate_v).
+	std::uint32_t sample_rate{};
+	/// \brief Frame count at the native sample rate, 0 if unknown.
+	std::uint64_t frame_count{};
+	/// \brief Whether frame_count is an estimate (eg CBR MP3 without a Xing / VBRI header).
+	bool frame_count_estimated{};
+
+	[[nodiscard]] auto get_duration() const -> std::chrono::duration<float> {
+		if (sample_rate == 0) { return {}; }
+		return std::chrono::duration<float>{float(frame_count) / float(sample_rate)};
+	}
+};
+
+/// \brief Read metadata of encoded bytes in memory.
+/// Only headers are parsed, no PCM is decoded.
+/// \param bytes Encoded bytes.
+/// \param encoding Encoding format, if known.
+/// \returns nullopt if the format is not recognized.
+[[nodiscard]] auto probe_bytes(std::span<std::byte const> bytes, std::optional<Encoding> encoding = {})
+	-> std::optional<AudioInfo>;
+
+/// \brief Read metadata of an audio file.
+/// Only headers are read from disk, no PCM is decoded.
+/// \param path Path to audio file.
+/// \param encoding Encoding format, if known.
+/// \returns nullopt if the file could not be opened or the format is not recognized.
+[[nodiscard]] auto probe_file(char const* path, std::optional<Encoding> encoding = {}) -> std::optional<AudioInfo>;
+
+/// \brief Read metadata of multiple audio files in parallel.
+/// \param paths Paths to audio files.
+/// \param thread_count Number of worker threads, 0 for hardware concurrency.
+/// \returns Result per path, in the same order.
+[[nodiscard]] auto probe_files(std::span<char const* const> paths, std::uint32_t thread_count = 0)
+	-> std::vector<std::optional<AudioInfo>>;
+} // namespace capo
@@ -0,0 +1,75 @@
+#pragma once
+#include <capo/buffer.hpp>
+#include <capo/file_system.hpp>
+#include <capo/polymorphic.hpp>
+#include <capo/stream.hpp>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <span>
+#include <vector>
+
+namespace capo {
+/// \brief Audio Buffer that is decoded on a background thread, and can be played while decoding.
+/// Decoded samples are appended in place (never moved): streams read them without copying or locking.
+/// Decoding stops early if the memory budget is exceeded (see set_memory_budget()).
+/// All member functions are thread-safe.
+class IProgressiveBuffer : public Polymorphic {
+  public:
+	[[nodiscard]] virtual auto get_channels() const -> std::uint8_t = 0;
+	/// \brief Speaker position of each channel.
+	[[nodiscard]] virtual auto get_channel_map() const -> std::span<Channel const> = 0;
+
+	/// \brief Get the total number of frames.
+	/// \returns Decoded frame count if the decoder cannot report its length and decoding is not complete.
+	[[nodiscard]] virtual auto get_frame_count() const -> std::uint64_t = 0;
+	/// \brief Get the number of frames decoded so far.
+	[[nodiscard]] virtual auto get_decoded_frame_count() const -> std::uint64_t = 0;
+	/// \brief Check if decoding has finished (or stopped early).
+	[[nodiscard]] virtual auto is_complete() const -> bool = 0;
+
+	/// \brief Block until a number of frames have been decoded, or decoding is complete.
+	/// The calling thread is blocked via atomic wait/notify (not spinlocking).
+	/// \param frame_count Number of frames to wait for.
+	virtual void wait_for_frames(std::uint64_t frame_count) const = 0;
+
+	/// \brief Create a stream that plays this buffer, and holds a reference to it.
+	/// Each stream has its own cursor, bind it to a Source via ISource::bind_to().
+	/// Reading past the decoded frames (eg after seeking ahead) produces silence until they are decoded,
+	/// the cursor does not advance in the meantime.
+	[[nodiscard]] virtual auto create_stream() const -> std::shared_ptr<IStream> = 0;
+};
+
+struct ProgressiveBufferCreateInfo {
+	/// \brief Encoding format, if known.
+	std::optional<Encoding> encoding{};
+	/// \brief Duration to decode before returning, so that playback can start without an underrun.
+	std::chrono::duration<float> preroll{std::chrono::milliseconds{250}};
+};
+
+/// \brief Create a Progressive Buffer from encoded bytes.
+/// \param bytes Encoded bytes, owned by the buffer until decoding is complete.
+/// \param create_info Creation parameters.
+/// \returns null if the bytes could not be decoded.
+[[nodiscard]] auto create_progressive_buffer(std::vector<std::byte> bytes,
+											 ProgressiveBufferCreateInfo const& create_info = {})
+	-> std::shared_ptr<IProgressiveBuffer>;
+
+/// \brief Create a Progressive Buffer from an audio file.
+/// \param path Path to audio file.
+/// \param create_info Creation parameters, encoding is guessed from path if not set.
+/// \returns null if the file could not be opened or decoded.
+[[nodiscard]] auto create_progressive_buffer(char const* path, ProgressiveBufferCreateInfo const& create_info = {})
+	-> std::shared_ptr<IProgressiveBuffer>;
+
+/// \brief Create a Progressive Buffer from an audio file via a custom File System.
+/// \param file_system File System to open path with.
+/// \param path Path to audio file.
+/// \param create_info Creation parameters, encoding is guessed from path if not set.
+/// \returns null if the file could not be opened or decoded.
+[[nodiscard]] auto create_progressive_buffer(IFileSystem& file_system, char const* path,
+											 ProgressiveBufferCreateInfo create_info = {})
+	-> std::shared_ptr<IProgressiveBuffer>;
+} // namespace capo
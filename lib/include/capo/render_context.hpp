@@ -0,0 +1,80 @@
+#pragma once
+#include <capo/buffer.hpp>
+#include <capo/clock.hpp>
+#include <capo/file_system.hpp>
+#include <capo/source.hpp>
+#include <cstdint>
+#include <memory>
+#include <span>
+
+namespace capo {
+/// \brief Deviceless mixing context, for offline rendering.
+/// Sources are created and driven via the same ISource API as an Engine's, but nothing is mixed until render()
+/// is called, on the calling thread and as fast as it allows. Time only advances through render(),
+/// so fades, cursors and clocks are in rendered frames, and output is deterministic.
+/// Contexts share no state, any number of them can render concurrently (one thread per context at a time).
+/// Buffers are read-only while bound, and can be shared across contexts.
+/// Effects, Analyzers and MixGroups belong to an Engine: Sources of a render context must not be routed to them.
+class IRenderContext : public Polymorphic {
+  public:
+	[[nodiscard]] virtual auto get_sample_rate() const -> std::uint32_t = 0;
+	[[nodiscard]] virtual auto get_channels() const -> std::uint8_t = 0;
+
+	/// \brief Create an Audio Source that is mixed by this context.
+	/// \returns null on failure.
+	[[nodiscard]] virtual auto create_source() -> std::unique_ptr<ISource> = 0;
+
+	/// \brief Mix the next frames of all playing Sources.
+	/// File streams load on this thread as required (before each block), they never render silence while loading.
+	/// \param out Interleaved output, size must be a multiple of get_channels().
+	/// \returns Number of frames rendered.
+	virtual auto render(std::span<float> out) -> std::uint64_t = 0;
+
+	/// \brief Get the clock of the output: frames rendered so far.
+	[[nodiscard]] virtual auto get_clock() const -> PlaybackClock = 0;
+
+	/// \brief Obtain the listener's 3D position.
+	[[nodiscard]] virtual auto get_position() const -> Vec3f = 0;
+	/// \brief Set the listener's 3D position.
+	virtual void set_position(Vec3f const& position) = 0;
+
+	/// \brief Obtain the listener's direction as a unit vector.
+	[[nodiscard]] virtual auto get_direction() const -> Vec3f = 0;
+	/// \brief Set the listener's direction as a unit vector.
+	virtual void set_direction(Vec3f const& direction) = 0;
+
+	/// \brief Obtain the world up as a unit vector.
+	[[nodiscard]] virtual auto get_world_up() const -> Vec3f = 0;
+	/// \brief Set the world up as a unit vector.
+	virtual void set_world_up(Vec3f const& direction) = 0;
+};
+
+/// \brief Render context creation parameters.
+struct RenderContextCreateInfo {
+	std::uint32_t sample_rate{Buffer::sample_rate_v};
+	std::uint8_t channels{2};
+	/// \brief File System that file streams are opened with, null for the native one.
+	std::shared_ptr<IFileSystem> file_system{};
+};
+
+/// \brief Create a deviceless render context.
+/// Owns no threads and opens no device: cheap enough to create per render.
+/// \param create_info Creation parameters.
+/// \returns null on failure.
+[[nodiscard]] auto create_render_context(RenderContextCreateInfo const& create_info = {})
+	-> std::unique_ptr<IRenderContext>;
+
+/// \brief A render into memory: as many frames as fit in output.
+struct RenderJob {
+	IRenderContext* context{};
+	/// \brief Interleaved output, size must be a multiple of the context's channels.
+	std::span<float> output{};
+};
+
+/// \brief Render jobs in parallel, and wait for all of them to complete.
+/// Jobs are claimed one at a time by each thread, so uneven lengths balance out.
+/// Each context must appear in at most one job.
+/// \param jobs Jobs to render.
+/// \param thread_count Number of threads to render on (including the calling one), 0 for hardware concurrency.
+void render_batch(std::span<RenderJob const> jobs, std::uint32_t thread_count = 0);
+} // namespace capo
@@ -1,12 +1,27 @@
 #pragma once
+#include <capo/analyzer.hpp>
 #include <capo/buffer.hpp>
+#include <capo/buffer_view.hpp>
+#include <capo/clock.hpp>
+#include <capo/effect.hpp>
+#include <capo/mix_group.hpp>
 #include <capo/polymorphic.hpp>
 #include <capo/stream.hpp>
 #include <capo/vec3.hpp>
 #include <chrono>
+#include <cstdint>
 #include <memory>
+#include <optional>
 
 namespace capo {
+/// \brief Frames of a Source's data to loop over (eg the body of a track after its intro).
+struct LoopRegion {
+	/// \brief First frame of the loop.
+	std::uint64_t start{};
+	/// \brief One past the last frame of the loop, 0 for the end of the data.
+	std::uint64_t end{};
+};
+
 /// \brief Audio Source.
 /// API for audio playback.
 /// Open file for streaming or bind to existing Audio Buffer.
@@ -25,6 +40,11 @@ class ISource : public Polymorphic {
 	/// \param buffer Audio Buffer to bind source to.
 	/// \returns true on success.
 	virtual auto bind_to(std::shared_ptr<Buffer const> buffer) -> bool = 0;
+	/// \brief Bind to a range of frames in a buffer and increment its ref-count.
+	/// Plays and loops only the frames in view.
+	/// \param buffer_view View of Audio Buffer to bind source to.
+	/// \returns true on success.
+	virtual auto bind_to(BufferView const& buffer_view) -> bool = 0;
 	/// \brief Bind to custom stream (data source).
 	/// Passed stream must outlive this instance.
 	/// \param custom_stream Stream to bind to.
@@ -36,6 +56,7 @@ class ISource : public Polymorphic {
 	virtual auto bind_to(std::shared_ptr<IStream> custom_stream) -> bool = 0;
 	/// \brief Open file stream and bind to it.
 	/// The same encodings are supported as with capo::Buffer.
+	/// The file is opened via the Engine's File System (see EngineCreateInfo).
 	/// \param path Path to audio file.
 	/// \returns true on success.
 	virtual auto open_file_stream(char const* path) -> bool = 0;
@@ -65,6 +86,11 @@ class ISource : public Polymorphic {
 	[[nodiscard]] virtual auto get_cursor() const -> std::chrono::duration<float> = 0;
 	/// \brief Set position of playback cursor.
 	virtual auto set_cursor(std::chrono::duration<float> position) -> bool = 0;
+	/// \brief Get the playback clock, for synchronizing with the audio output.
+	/// Unlike get_cursor(), frames are exact and the audible position can be interpolated between callbacks.
+	/// Async Sources return the last published clock, which can still be interpolated from.
+	/// \returns Default (0 sample rate) if not bound.
+	[[nodiscard]] virtual auto get_clock() const -> PlaybackClock = 0;
 
 	/// \brief Check if spatialization is enabled.
 	/// \returns true if bound and spatialized.
@@ -86,6 +112,16 @@ class ISource : public Polymorphic {
 	[[nodiscard]] virtual auto is_looping() const -> bool = 0;
 	virtual void set_looping(bool looping) = 0;
 
+	[[nodiscard]] virtual auto get_loop_region() const -> std::optional<LoopRegion> = 0;
+	/// \brief Set the region to loop over while looping, nullopt to loop over all the data.
+	/// Playback runs from the cursor through the end of the region, then wraps to its start (sample accurately).
+	/// The first ~0.5s of the region is cached as it plays, and served from memory after each wrap
+	/// while the underlying data seeks, so file streams never wait on a seek / decode at the loop point.
+	/// Custom IStreams still have seek_to_sample() called (from the audio thread) on each wrap.
+	/// Persists across binds.
+	/// \returns false if end is non-zero and not after start.
+	virtual auto set_loop_region(std::optional<LoopRegion> region) -> bool = 0;
+
 	[[nodiscard]] virtual auto get_gain() const -> float = 0;
 	virtual void set_gain(float gain) = 0;
 
@@ -97,5 +133,30 @@ class ISource : public Polymorphic {
 
 	[[nodiscard]] virtual auto get_pitch() const -> float = 0;
 	virtual void set_pitch(float pitch) = 0;
+
+	/// \brief Get the Effect this outputs to.
+	/// \returns null if outputting directly to the Engine.
+	[[nodiscard]] virtual auto get_output() const -> IEffect* = 0;
+	/// \brief Route output through an Effect, or directly to the Engine.
+	/// Persists across binds.
+	/// \param effect Effect created by the same Engine, null to output directly.
+	virtual void set_output(IEffect* effect) = 0;
+
+	/// \brief Get the Analyzer this outputs through.
+	/// \returns null if not analyzed.
+	[[nodiscard]] virtual auto get_analyzer() const -> IAnalyzer* = 0;
+	/// \brief Route output through an Analyzer, to the Analyzer's output (see IAnalyzer::set_output()).
+	/// Persists across binds. While analyzed, the output set via set_output() is bypassed.
+	/// Sources sharing an Analyzer are analyzed as a mix.
+	/// \param analyzer Analyzer created by the same Engine, null to stop analyzing.
+	virtual void set_analyzer(IAnalyzer* analyzer) = 0;
+
+	/// \brief Get the MixGroup this is mixed in.
+	/// \returns null if mixed on the audio thread.
+	[[nodiscard]] virtual auto get_mix_group() const -> IMixGroup* = 0;
+	/// \brief Mix in a MixGroup (in parallel, on a worker thread), or on the audio thread.
+	/// Persists across binds. While in a group, the output Effect and Analyzer are bypassed.
+	/// \param group MixGroup created by the same Engine, null to mix on the audio thread.
+	virtual void set_mix_group(IMixGroup* group) = 0;
 };
 } // namespace capo
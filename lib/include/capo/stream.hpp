@@ -1,4 +1,5 @@
 #pragma once
+#include <capo/channel_layout.hpp>
 #include <capo/polymorphic.hpp>
 #include <cstddef>
 #include <cstdint>
@@ -15,10 +16,27 @@ class IStream : public Polymorphic {
 	[[nodiscard]] virtual auto get_sample_rate() const -> std::uint32_t = 0;
 	/// \brief Must return positive value.
 	[[nodiscard]] virtual auto get_channels() const -> std::uint8_t = 0;
+	/// \brief Speaker position of each channel, size must match get_channels().
+	[[nodiscard]] virtual auto get_channel_map() const -> std::span<Channel const> {
+		return get_default_channel_map(get_channels());
+	}
 
 	/// \returns Count of samples read, 0 if at end.
 	[[nodiscard]] virtual auto read_samples(std::span<float> out) -> std::size_t = 0;
 
+	/// \brief Optional zero-copy read: expose the next samples in the stream's own memory.
+	/// The library consumes samples directly from the returned span, instead of via read_samples().
+	/// Only called on the audio thread, each call is followed by release_samples().
+	/// \param max_count Maximum number of samples required (whole frames).
+	/// \returns Contiguous samples (whole frames) valid until release, empty if at end, nullopt if not supported.
+	[[nodiscard]] virtual auto acquire_samples([[maybe_unused]] std::size_t max_count)
+		-> std::optional<std::span<float const>> {
+		return {};
+	}
+	/// \brief Advance the stream past samples consumed from acquire_samples().
+	/// \param count Number of samples consumed, never more than were acquired.
+	virtual void release_samples([[maybe_unused]] std::size_t count) {}
+
 	/// \param index Sample index to seek to.
 	/// \returns false if seeking is not supported.
 	[[nodiscard]] virtual auto seek_to_sample([[maybe_unused]] std::size_t index) -> bool { return false; }
@@ -1,4 +1,5 @@
 #pragma once
+#include <capo/memory.hpp>
 #include <capo/stream.hpp>
 #include <vector>
 
@@ -13,10 +14,14 @@ class IStreamPipe : public IStream {
 
   private:
 	[[nodiscard]] auto read_samples(std::span<float> out) -> std::size_t final;
+	[[nodiscard]] auto acquire_samples(std::size_t max_count) -> std::optional<std::span<float const>> final;
+	void release_samples(std::size_t count) final;
 
-	auto drain_buffer(std::span<float> out) -> std::size_t;
+	auto fill_buffer(std::size_t count) -> std::span<float const>;
 
 	std::vector<float> m_buffer{};
-	std::vector<float> m_staging{};
+	// index of the first unconsumed sample in m_buffer.
+	std::size_t m_read{};
+	MemoryCharge m_charge{MemoryCategory::StreamBuffers, 0};
 };
 } // namespace capo
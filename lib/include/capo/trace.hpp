@@ -0,0 +1,26 @@
+#pragma once
+#include <string>
+
+namespace capo {
+/// \brief Check whether tracing spans were compiled in (CMake option CAPO_TRACE).
+/// When not, the functions below are no-ops and exports contain no events.
+[[nodiscard]] auto is_trace_available() -> bool;
+
+/// \brief Check whether spans are being recorded (initially true if available).
+[[nodiscard]] auto is_trace_enabled() -> bool;
+/// \brief Pause / resume recording of spans.
+void set_trace_enabled(bool enabled);
+
+/// \brief Discard all spans recorded so far.
+void clear_trace();
+
+/// \brief Get recorded spans in the Chrome trace event format (chrome://tracing, ui.perfetto.dev).
+/// Spans are recorded into per-thread rings of the most recent 8192 each,
+/// the audio thread and loading threads never block on each other or on an export.
+/// The ring of an exited thread is reused by the next thread to record spans, on the same track (tid).
+[[nodiscard]] auto get_trace_json() -> std::string;
+/// \brief Write recorded spans to a JSON file, see get_trace_json().
+/// \param path Path to output file (overwritten if it exists).
+/// \returns false if the file could not be written.
+[[nodiscard]] auto write_trace_file(char const* path) -> bool;
+} // namespace capo
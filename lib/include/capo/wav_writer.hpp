@@ -0,0 +1,57 @@
+#pragma once
+#include <capo/buffer.hpp>
+#include <capo/polymorphic.hpp>
+#include <capo/stream.hpp>
+#include <cstdint>
+#include <memory>
+#include <span>
+
+namespace capo {
+/// \brief Sample format of WAV output.
+enum class WavFormat : std::int8_t { F32, S16 };
+
+/// \brief Streaming WAV file writer.
+/// Encoded bytes are staged in a large buffer and written to disk in big chunks.
+/// The header is finalized on finish() or destruction.
+class IWavWriter : public Polymorphic {
+  public:
+	[[nodiscard]] virtual auto get_channels() const -> std::uint8_t = 0;
+	[[nodiscard]] virtual auto get_sample_rate() const -> std::uint32_t = 0;
+	[[nodiscard]] virtual auto get_format() const -> WavFormat = 0;
+	[[nodiscard]] virtual auto get_frames_written() const -> std::uint64_t = 0;
+
+	/// \brief Encode interleaved samples.
+	/// \param samples Interleaved samples, size must be a multiple of channel count.
+	/// \returns false on failure, or if already finished.
+	virtual auto write_samples(std::span<float const> samples) -> bool = 0;
+
+	/// \brief Flush all pending data and finalize the header.
+	/// \returns false on failure.
+	virtual auto finish() -> bool = 0;
+};
+
+/// \brief Create a WAV writer.
+/// \param path Path to output file (overwritten if it exists).
+/// \param channels Channel count.
+/// \param sample_rate Sample rate.
+/// \param format Sample format to encode to.
+/// \returns null on failure.
+[[nodiscard]] auto create_wav_writer(char const* path, std::uint8_t channels,
+									 std::uint32_t sample_rate = Buffer::sample_rate_v,
+									 WavFormat format = WavFormat::F32) -> std::unique_ptr<IWavWriter>;
+
+/// \brief Write a Buffer to a WAV file.
+/// \param buffer Audio Buffer to write.
+/// \param path Path to output file.
+/// \param format Sample format to encode to.
+/// \returns true on success.
+[[nodiscard]] auto write_wav_file(Buffer const& buffer, char const* path, WavFormat format = WavFormat::F32) -> bool;
+
+/// \brief Drain a stream into a WAV file.
+/// Reads until the stream returns 0 samples, so it must not be of indefinite length.
+/// \param stream Stream to read from.
+/// \param path Path to output file.
+/// \param format Sample format to encode to.
+/// \returns true on success.
+[[nodiscard]] auto write_wav_file(IStream& stream, char const* path, WavFormat format = WavFormat::F32) -> bool;
+} // namespace capo
@@ -0,0 +1,253 @@
+#include <miniaudio.h>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cmath>
+#include <numbers>
+#include <vector>
+#include "analyzer.hpp"
+#include "effect_graph.hpp"
+#include "fft.hpp"
+#include "snapshot.hpp"
+
+namespace capo {
+namespace {
+constexpr auto min_fft_size_v = 64u;
+constexpr auto max_fft_size_v = 16384u;
+
+// normalized so that a full scale sine peaks at 1: scaled by 2 / sum of window.
+auto make_window(FftWindow const window, std::size_t const size) -> std::vector<float> {
+	static constexpr auto tau_v = 2.0 * std::numbers::pi;
+	auto ret = std::vector<float>(size, 1.0f);
+	for (auto i = 0uz; i < size; ++i) {
+		auto const x = tau_v * double(i) / double(size);
+		switch (window) {
+		case FftWindow::Hann: ret.at(i) = float(0.5 - (0.5 * std::cos(x))); break;
+		case FftWindow::BlackmanHarris:
+			ret.at(i) = float(0.35875 - (0.48829 * std::cos(x)) + (0.14128 * std::cos(2.0 * x)) -
+							  (0.01168 * std::cos(3.0 * x)));
+			break;
+		case FftWindow::Rectangular: break;
+		}
+	}
+	auto sum = 0.0f;
+	for (auto const w : ret) { sum += w; }
+	for (auto& w : ret) { w *= 2.0f / sum; }
+	return ret;
+}
+
+// spectra are published round-robin into slots, readers copy the latest one.
+// a read only has to retry if the writer laps it (publishes twice during one copy).
+class SpectrumSlots {
+  public:
+	explicit SpectrumSlots(std::size_t const bin_count) {
+		for (auto& slot : m_slots) { slot.bins = std::vector<std::atomic<float>>(bin_count); }
+	}
+
+	// must only be called from one thread at a time.
+	void publish(std::span<float const> bins) {
+		auto const index = m_published.load(std::memory_order_relaxed) + 1;
+		auto& slot = m_slots.at(index % m_slots.size());
+		slot.version.store((index * 2) - 1, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_release);
+		for (auto i = 0uz; i < bins.size(); ++i) { slot.bins[i].store(bins[i], std::memory_order_relaxed); }
+		slot.version.store(index * 2, std::memory_order_release);
+		m_published.store(index, std::memory_order_release);
+	}
+
+	auto read(std::span<float> out) const -> std::uint64_t {
+		while (true) {
+			auto const index = m_published.load(std::memory_order_acquire);
+			if (index == 0) {
+				std::ranges::fill(out, 0.0f);
+				return 0;
+			}
+			auto const& slot = m_slots.at(index % m_slots.size());
+			auto const version = slot.version.load(std::memory_order_acquire);
+			if (version != index * 2) { continue; }
+			auto const count = std::min(out.size(), slot.bins.size());
+			for (auto i = 0uz; i < count; ++i) { out[i] = slot.bins[i].load(std::memory_order_relaxed); }
+			std::atomic_thread_fence(std::memory_order_acquire);
+			if (slot.version.load(std::memory_order_relaxed) == version) { return index; }
+		}
+	}
+
+  private:
+	struct Slot {
+		std::atomic<std::uint64_t> version{};
+		std::vector<std::atomic<float>> bins{};
+	};
+
+	std::array<Slot, 3> m_slots{};
+	std::atomic<std::uint64_t> m_published{};
+};
+
+class Analyzer : public IAnalyzer {
+  public:
+	Analyzer(Analyzer const&) = delete;
+	Analyzer(Analyzer&&) = delete;
+	auto operator=(Analyzer const&) -> Analyzer& = delete;
+	auto operator=(Analyzer&&) -> Analyzer& = delete;
+
+	explicit Analyzer(ma_engine& engine, AnalyzerCreateInfo const& create_info)
+		: m_engine(engine),
+		  m_fft(std::bit_ceil(std::clamp(create_info.fft_size, min_fft_size_v, max_fft_size_v))),
+		  m_hop_size(create_info.hop_size), m_smoothing(std::clamp(create_info.smoothing, 0.0f, 0.99f)),
+		  m_spectrum(m_fft.get_bin_count()) {
+		auto const fft_size = m_fft.get_size();
+		if (m_hop_size == 0) { m_hop_size = fft_size / 4; }
+		m_window = make_window(create_info.window, fft_size);
+		m_ring.resize(fft_size);
+		m_work.resize(fft_size);
+		m_bins.resize(m_fft.get_bin_count());
+		m_smoothed.resize(m_fft.get_bin_count());
+	}
+
+	~Analyzer() {
+		if (!m_node_ready) { return; }
+		ma_node_uninit(&m_node, &m_engine.allocationCallbacks);
+	}
+
+	auto init() -> bool {
+		auto channels = ma_engine_get_channels(&m_engine);
+		auto config = ma_node_config_init();
+		config.vtable = &s_vtable;
+		config.pInputChannels = &channels;
+		config.pOutputChannels = &channels;
+		auto* graph = ma_engine_get_node_graph(&m_engine);
+		if (ma_node_init(graph, &config, &m_engine.allocationCallbacks, &m_node) != MA_SUCCESS) { return false; }
+		m_node.analyzer = this;
+		m_node_ready = true;
+		set_output(nullptr);
+		return true;
+	}
+
+	[[nodiscard]] auto get_node() -> ma_node* { return &m_node; }
+
+	[[nodiscard]] auto get_fft_size() const -> std::uint32_t final { return std::uint32_t(m_fft.get_size()); }
+	[[nodiscard]] auto get_bin_count() const -> std::uint32_t final { return std::uint32_t(m_fft.get_bin_count()); }
+
+	[[nodiscard]] auto get_bin_frequency(std::uint32_t const bin) const -> float final {
+		return float(bin) * float(ma_engine_get_sample_rate(&m_engine)) / float(m_fft.get_size());
+	}
+
+	auto get_spectrum(std::span<float> out) const -> std::uint64_t final { return m_spectrum.read(out); }
+
+	[[nodiscard]] auto get_levels() const -> Levels final { return m_levels.load(); }
+
+	[[nodiscard]] auto get_output() const -> IEffect* final { return m_output; }
+
+	void set_output(IEffect* effect) final {
+		ma_node_attach_output_bus(&m_node, 0, detail::get_input_node(m_engine, effect), 0);
+		m_output = effect;
+	}
+
+	// called on the audio thread.
+	void process(std::span<float const> samples) {
+		auto const channels = std::size_t(ma_engine_get_channels(&m_engine));
+		auto const mask = m_ring.size() - 1;
+		auto const scale = 1.0f / float(channels);
+		for (auto offset = 0uz; offset + channels <= samples.size(); offset += channels) {
+			auto mono = 0.0f;
+			for (auto const sample : samples.subspan(offset, channels)) {
+				mono += sample;
+				m_peak = std::max(m_peak, std::abs(sample));
+				m_sum_squares += sample * sample;
+			}
+			m_ring[m_write] = mono * scale;
+			m_write = (m_write + 1) & mask;
+		}
+		m_level_samples += samples.size();
+		m_pending += samples.size() / channels;
+		if (m_pending < m_hop_size) { return; }
+		m_pending %= m_hop_size;
+		analyze();
+	}
+
+  private:
+	struct Node : ma_node_base {
+		Analyzer* analyzer{};
+	};
+
+	void analyze() {
+		// unroll the ring (oldest first) and apply the window.
+		auto const mask = m_ring.size() - 1;
+		for (auto i = 0uz; i < m_work.size(); ++i) { m_work[i] = m_ring[(m_write + i) & mask] * m_window[i]; }
+		m_fft.compute_magnitudes(m_work, m_bins);
+		// DC and Nyquist are not mirrored, and have half the gain of other bins.
+		m_bins.front() *= 0.5f;
+		m_bins.back() *= 0.5f;
+		for (auto i = 0uz; i < m_bins.size(); ++i) {
+			m_smoothed[i] = (m_smoothing * m_smoothed[i]) + ((1.0f - m_smoothing) * m_bins[i]);
+		}
+		m_spectrum.publish(m_smoothed);
+
+		auto const rms = m_level_samples > 0 ? std::sqrt(m_sum_squares / float(m_level_samples)) : 0.0f;
+		m_levels.store(Levels{.peak = m_peak, .rms = rms});
+		m_peak = m_sum_squares = 0.0f;
+		m_level_samples = 0;
+	}
+
+	static ma_node_vtable const s_vtable;
+
+	ma_engine& m_engine;
+	detail::RealFft m_fft;
+	std::size_t m_hop_size{};
+	float m_smoothing{};
+
+	// only accessed on the audio thread.
+	std::vector<float> m_window{};
+	std::vector<float> m_ring{};
+	std::vector<float> m_work{};
+	std::vector<float> m_bins{};
+	std::vector<float> m_smoothed{};
+	std::size_t m_write{};
+	std::size_t m_pending{};
+	float m_peak{};
+	float m_sum_squares{};
+	std::size_t m_level_samples{};
+
+	SpectrumSlots m_spectrum;
+	detail::Snapshot<Levels> m_levels{};
+
+	Node m_node{};
+	bool m_node_ready{};
+	IEffect* m_output{};
+};
+
+// passthrough: the graph reads input straight into the output, the callback only observes it.
+ma_node_vtable const Analyzer::s_vtable = {
+	.onProcess = [](ma_node* node, float const** frames_in, ma_uint32* frame_count_in, float** /*frames_out*/,
+					ma_uint32* /*frame_count_out*/) {
+		auto& self = *static_cast<Node*>(node)->analyzer;
+		auto const channels = ma_node_get_input_channels(node, 0);
+		self.process(std::span{frames_in[0], std::size_t(*frame_count_in) * channels});
+	},
+	.onGetRequiredInputFrameCount = nullptr,
+	.inputBusCount = 1,
+	.outputBusCount = 1,
+	.flags = MA_NODE_FLAG_PASSTHROUGH,
+};
+} // namespace
+
+auto detail::create_analyzer(ma_engine& engine, AnalyzerCreateInfo const& create_info)
+	-> std::unique_ptr<IAnalyzer> {
+	auto ret = std::make_unique<Analyzer>(engine, create_info);
+	if (!ret->init()) { return {}; }
+	return ret;
+}
+
+void detail::attach_output(ma_node* node, IAnalyzer* analyzer, ma_node* output) {
+	if (analyzer == nullptr) {
+		ma_node_attach_output_bus(node, 0, output, 0);
+		return;
+	}
+	// all Analyzers are created by create_analyzer().
+	ma_node_attach_output_bus(node, 0, static_cast<Analyzer*>(analyzer)->get_node(), 0);
+}
+
+void detail::analyze_output(IAnalyzer& analyzer, std::span<float const> samples) {
+	static_cast<Analyzer&>(analyzer).process(samples);
+}
+} // namespace capo
@@ -0,0 +1,20 @@
+#pragma once
+#include <miniaudio.h>
+#include <capo/analyzer.hpp>
+#include <memory>
+#include <span>
+
+namespace capo::detail {
+/// \brief Create an Analyzer with a passthrough node in an engine's node graph, initially outputting to its endpoint.
+/// \returns null on failure.
+[[nodiscard]] auto create_analyzer(ma_engine& engine, AnalyzerCreateInfo const& create_info)
+	-> std::unique_ptr<IAnalyzer>;
+
+/// \brief Route a node to an output, or to an Analyzer (which routes to its own output) if set.
+/// \param analyzer Analyzer created by create_analyzer(), null to attach directly.
+void attach_output(ma_node* node, IAnalyzer* analyzer, ma_node* output);
+
+/// \brief Analyze interleaved frames of the engine's output, must only be called on the audio thread.
+/// \param analyzer Analyzer created by create_analyzer().
+void analyze_output(IAnalyzer& analyzer, std::span<float const> samples);
+} // namespace capo::detail
@@ -0,0 +1,573 @@
+#include <capo/async_file_system.hpp>
+#include <capo/memory.hpp>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <mutex>
+#include <semaphore>
+#include <thread>
+#include <vector>
+#include "mpsc_queue.hpp"
+
+#if defined(CAPO_IO_URING)
+#include <cerrno>
+#include <fcntl.h>
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#endif
+
+using namespace std::chrono_literals;
+
+namespace capo {
+namespace {
+using Clock = std::chrono::steady_clock;
+
+// native file: a descriptor for io_uring, a stream for the thread pool.
+struct Handle {
+	Handle(Handle const&) = delete;
+	Handle(Handle&&) = delete;
+	auto operator=(Handle const&) -> Handle& = delete;
+	auto operator=(Handle&&) -> Handle& = delete;
+
+	Handle() = default;
+
+#if defined(CAPO_IO_URING)
+	~Handle() {
+		if (fd >= 0) { ::close(fd); }
+	}
+
+	int fd{-1};
+#else
+	~Handle() = default;
+#endif
+
+	std::ifstream stream{};
+	std::uint64_t size{};
+};
+
+struct Request {
+	Handle* handle{};
+	std::span<std::byte> buffer{};
+	std::uint64_t offset{};
+	std::size_t bytes_read{};
+	// I/O error (the read is short), once done.
+	bool failed{};
+	Clock::time_point submitted{};
+	std::atomic_bool done{true};
+#if defined(CAPO_IO_URING)
+	iovec io_vec{};
+#endif
+
+	void wait() const { done.wait(false); }
+};
+
+class Stats {
+  public:
+	void on_submit() {
+		auto const depth = m_depth.fetch_add(1) + 1;
+		auto max = m_max_depth.load();
+		while (depth > max && !m_max_depth.compare_exchange_weak(max, depth)) {}
+	}
+
+	void on_complete(Request const& request) {
+		auto const latency = std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - request.submitted);
+		m_depth.fetch_sub(1);
+		m_reads.fetch_add(1);
+		m_bytes_read.fetch_add(request.bytes_read);
+		m_total_latency_us.fetch_add(std::uint64_t(latency.count()));
+		auto max = m_max_latency_us.load();
+		while (std::uint64_t(latency.count()) > max &&
+			   !m_max_latency_us.compare_exchange_weak(max, std::uint64_t(latency.count()))) {}
+	}
+
+	[[nodiscard]] auto get() const -> IoStats {
+		auto ret = IoStats{
+			.queue_depth = m_depth.load(),
+			.max_queue_depth = m_max_depth.load(),
+			.reads = m_reads.load(),
+			.bytes_read = m_bytes_read.load(),
+			.max_latency = std::chrono::microseconds{m_max_latency_us.load()},
+		};
+		if (ret.reads > 0) { ret.average_latency = std::chrono::microseconds{m_total_latency_us.load() / ret.reads}; }
+		return ret;
+	}
+
+  private:
+	std::atomic<std::uint32_t> m_depth{};
+	std::atomic<std::uint32_t> m_max_depth{};
+	std::atomic<std::uint64_t> m_reads{};
+	std::atomic<std::uint64_t> m_bytes_read{};
+	std::atomic<std::uint64_t> m_total_latency_us{};
+	std::atomic<std::uint64_t> m_max_latency_us{};
+};
+
+// I/O backend: completes submitted reads asynchronously.
+class IoQueue : public Polymorphic {
+  public:
+	[[nodiscard]] virtual auto get_backend() const -> IoBackend = 0;
+	[[nodiscard]] virtual auto open(char const* path) -> std::unique_ptr<Handle> = 0;
+	virtual void submit(Request& request) = 0;
+
+	[[nodiscard]] auto get_stats() const -> IoStats { return m_stats.get(); }
+
+  protected:
+	void begin(Request& request) {
+		request.done.store(false);
+		request.submitted = Clock::now();
+		m_stats.on_submit();
+	}
+
+	void complete(Request& request, std::size_t const bytes_read, bool const failed = false) {
+		request.bytes_read = bytes_read;
+		request.failed = failed;
+		m_stats.on_complete(request);
+		// request may be destroyed by its owner from here on.
+		request.done.store(true);
+		request.done.notify_all();
+	}
+
+  private:
+	Stats m_stats{};
+};
+
+class ThreadPoolQueue : public IoQueue {
+  public:
+	explicit ThreadPoolQueue(std::uint32_t const worker_count) {
+		m_workers.reserve(std::max(worker_count, 1u));
+		for (auto i = 0u; i < std::max(worker_count, 1u); ++i) {
+			m_workers.emplace_back([this](std::stop_token const& stop) { run(stop); });
+		}
+	}
+
+	[[nodiscard]] auto get_backend() const -> IoBackend final { return IoBackend::ThreadPool; }
+
+	[[nodiscard]] auto open(char const* path) -> std::unique_ptr<Handle> final {
+		auto ret = std::make_unique<Handle>();
+		ret->stream.open(path, std::ios::binary | std::ios::ate);
+		if (!ret->stream) { return {}; }
+		ret->size = std::uint64_t(ret->stream.tellg());
+		return ret;
+	}
+
+	void submit(Request& request) final {
+		begin(request);
+		{
+			auto lock = std::scoped_lock{m_mutex};
+			m_requests.push_back(&request);
+		}
+		m_cv.notify_one();
+	}
+
+  private:
+	void run(std::stop_token const& stop) {
+		while (true) {
+			auto lock = std::unique_lock{m_mutex};
+			if (!m_cv.wait(lock, stop, [this] { return !m_requests.empty(); })) { return; }
+			auto* request = m_requests.front();
+			m_requests.pop_front();
+			lock.unlock();
+
+			// AsyncFile never overlaps reads of a file, so no two workers use the same stream.
+			auto& stream = request->handle->stream;
+			stream.clear();
+			stream.seekg(std::streamoff(request->offset));
+			void* data = request->buffer.data();
+			stream.read(static_cast<char*>(data), std::streamsize(request->buffer.size()));
+			complete(*request, std::size_t(stream.gcount()), stream.bad());
+		}
+	}
+
+	std::mutex m_mutex{};
+	std::condition_variable_any m_cv{};
+	std::deque<Request*> m_requests{};
+	std::vector<std::jthread> m_workers{};
+};
+
+#if defined(CAPO_IO_URING)
+// minimal io_uring over raw syscalls (no liburing dependency).
+// the submission ring is only written to by the I/O thread.
+class IoUring {
+  public:
+	IoUring(IoUring const&) = delete;
+	IoUring(IoUring&&) = delete;
+	auto operator=(IoUring const&) -> IoUring& = delete;
+	auto operator=(IoUring&&) -> IoUring& = delete;
+
+	explicit IoUring(unsigned const entries) {
+		auto params = io_uring_params{};
+		m_fd = int(::syscall(__NR_io_uring_setup, entries, &params));
+		if (m_fd < 0) { return; }
+
+		m_sq_ring_size = params.sq_off.array + (params.sq_entries * sizeof(unsigned));
+		m_cq_ring_size = params.cq_off.cqes + (params.cq_entries * sizeof(io_uring_cqe));
+		auto const single_mmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+		if (single_mmap) { m_sq_ring_size = m_cq_ring_size = std::max(m_sq_ring_size, m_cq_ring_size); }
+		m_sqes_size = params.sq_entries * sizeof(io_uring_sqe);
+
+		m_sq_ring = map(m_sq_ring_size, IORING_OFF_SQ_RING);
+		m_cq_ring = single_mmap ? m_sq_ring : map(m_cq_ring_size, IORING_OFF_CQ_RING);
+		m_sqes = static_cast<io_uring_sqe*>(map(m_sqes_size, IORING_OFF_SQES));
+		if (m_sq_ring == nullptr || m_cq_ring == nullptr || m_sqes == nullptr) {
+			release();
+			return;
+		}
+
+		auto* sq = static_cast<std::byte*>(m_sq_ring);
+		m_sq_head = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+		m_sq_tail = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+		m_sq_mask = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+		m_sq_array = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+		m_sq_entries = params.sq_entries;
+
+		auto* cq = static_cast<std::byte*>(m_cq_ring);
+		m_cq_head = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+		m_cq_tail = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+		m_cq_mask = *reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+		m_cqes = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+	}
+
+	~IoUring() { release(); }
+
+	[[nodiscard]] auto is_ready() const -> bool { return m_fd >= 0; }
+
+	// queue a read, submitted on the next enter().
+	[[nodiscard]] auto push_read(Request& request) -> bool {
+		auto const tail = *m_sq_tail;
+		auto const head = std::atomic_ref{*m_sq_head}.load(std::memory_order_acquire);
+		if (tail - head >= m_sq_entries) { return false; }
+
+		auto const index = tail & m_sq_mask;
+		auto& sqe = m_sqes[index];
+		sqe = io_uring_sqe{};
+		// resubmitted reads continue where the previous (short) one stopped.
+		auto const remaining = request.buffer.subspan(request.bytes_read);
+		request.io_vec = iovec{.iov_base = remaining.data(), .iov_len = remaining.size()};
+		// READV rather than READ: supported since the first io_uring kernels (5.1).
+		sqe.opcode = IORING_OP_READV;
+		sqe.fd = request.handle->fd;
+		sqe.addr = std::uint64_t(reinterpret_cast<std::uintptr_t>(&request.io_vec));
+		sqe.len = 1;
+		sqe.off = request.offset + request.bytes_read;
+		sqe.user_data = std::uint64_t(reinterpret_cast<std::uintptr_t>(&request));
+		m_sq_array[index] = index;
+		std::atomic_ref{*m_sq_tail}.store(tail + 1, std::memory_order_release);
+		return true;
+	}
+
+	// submit queued reads and wait for at least min_complete completions.
+	// returns number of reads submitted, negative on error.
+	auto enter(unsigned const to_submit, unsigned const min_complete) const -> int {
+		auto const flags = min_complete > 0 ? unsigned(IORING_ENTER_GETEVENTS) : 0u;
+		return int(::syscall(__NR_io_uring_enter, m_fd, to_submit, min_complete, flags, nullptr, 0));
+	}
+
+	template <typename F>
+	void reap(F func) {
+		auto head = *m_cq_head;
+		auto const tail = std::atomic_ref{*m_cq_tail}.load(std::memory_order_acquire);
+		for (; head != tail; ++head) {
+			auto const& cqe = m_cqes[head & m_cq_mask];
+			func(*reinterpret_cast<Request*>(std::uintptr_t(cqe.user_data)), cqe.res);
+		}
+		std::atomic_ref{*m_cq_head}.store(head, std::memory_order_release);
+	}
+
+  private:
+	[[nodiscard]] auto map(std::size_t const size, off_t const offset) const -> void* {
+		auto* ret = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_fd, offset);
+		return ret == MAP_FAILED ? nullptr : ret;
+	}
+
+	void release() {
+		if (m_sqes != nullptr) { ::munmap(m_sqes, m_sqes_size); }
+		if (m_cq_ring != nullptr && m_cq_ring != m_sq_ring) { ::munmap(m_cq_ring, m_cq_ring_size); }
+		if (m_sq_ring != nullptr) { ::munmap(m_sq_ring, m_sq_ring_size); }
+		if (m_fd >= 0) { ::close(m_fd); }
+		m_sqes = nullptr;
+		m_cq_ring = m_sq_ring = nullptr;
+		m_fd = -1;
+	}
+
+	int m_fd{-1};
+	void* m_sq_ring{};
+	void* m_cq_ring{};
+	io_uring_sqe* m_sqes{};
+	std::size_t m_sq_ring_size{};
+	std::size_t m_cq_ring_size{};
+	std::size_t m_sqes_size{};
+
+	unsigned* m_sq_head{};
+	unsigned* m_sq_tail{};
+	unsigned* m_sq_array{};
+	unsigned m_sq_mask{};
+	unsigned m_sq_entries{};
+
+	unsigned* m_cq_head{};
+	unsigned* m_cq_tail{};
+	io_uring_cqe* m_cqes{};
+	unsigned m_cq_mask{};
+};
+
+// one capo thread batches the reads of all files into io_uring submissions.
+class IoUringQueue : public IoQueue {
+  public:
+	static constexpr auto entries_v = 256u;
+
+	IoUringQueue() : m_ring(entries_v) {
+		if (!m_ring.is_ready()) { return; }
+		m_thread = std::jthread{[this](std::stop_token const& stop) { run(stop); }};
+	}
+
+	[[nodiscard]] auto is_ready() const -> bool { return m_ring.is_ready(); }
+
+	[[nodiscard]] auto get_backend() const -> IoBackend final { return IoBackend::IoUring; }
+
+	[[nodiscard]] auto open(char const* path) -> std::unique_ptr<Handle> final {
+		auto ret = std::make_unique<Handle>();
+		ret->fd = ::open(path, O_RDONLY | O_CLOEXEC);
+		if (ret->fd < 0) { return {}; }
+		struct stat info{};
+		if (::fstat(ret->fd, &info) != 0) { return {}; }
+		ret->size = std::uint64_t(info.st_size);
+		return ret;
+	}
+
+	void submit(Request& request) final {
+		begin(request);
+		request.bytes_read = 0;
+		auto* pointer = &request;
+		while (!m_requests.try_push(std::move(pointer))) { std::this_thread::yield(); }
+		m_signal.release();
+	}
+
+  private:
+	void run(std::stop_token const& stop) {
+		auto in_flight = 0u;
+		auto to_submit = 0u;
+		// files wait for their reads before closing, so nothing is in flight when stop is requested.
+		while (!stop.stop_requested() || in_flight > 0) {
+			while (!m_backlog.empty() && m_ring.push_read(*m_backlog.front())) {
+				m_backlog.pop_front();
+				++to_submit;
+			}
+			while (auto request = m_requests.try_pop()) {
+				if (!m_backlog.empty() || !m_ring.push_read(**request)) {
+					m_backlog.push_back(*request);
+					continue;
+				}
+				++to_submit;
+			}
+
+			if (to_submit == 0 && in_flight == 0) {
+				std::ignore = m_signal.try_acquire_for(10ms);
+				continue;
+			}
+
+			auto const submitted = m_ring.enter(to_submit, 1);
+			if (submitted > 0) {
+				in_flight += unsigned(submitted);
+				to_submit -= unsigned(submitted);
+			} else if (submitted < 0 && submitted != -EINTR) {
+				// eg EAGAIN / EBUSY (out of resources): back off instead of spinning, then retry.
+				std::this_thread::sleep_for(1ms);
+			}
+
+			m_ring.reap([&](Request& request, int const result) {
+				--in_flight;
+				on_result(request, result);
+			});
+		}
+	}
+
+	void on_result(Request& request, int const result) {
+		if (result == -EINTR || result == -EAGAIN) {
+			m_backlog.push_back(&request);
+			return;
+		}
+		if (result < 0) {
+			complete(request, request.bytes_read, true);
+			return;
+		}
+		request.bytes_read += std::size_t(result);
+		// short read before the end of the file: read the rest.
+		auto const end = request.offset + request.bytes_read;
+		if (result > 0 && request.bytes_read < request.buffer.size() && end < request.handle->size) {
+			m_backlog.push_back(&request);
+			return;
+		}
+		complete(request, request.bytes_read);
+	}
+
+	static constexpr auto queue_capacity_v = 1024uz;
+
+	IoUring m_ring;
+	detail::MpscQueue<Request*> m_requests{queue_capacity_v};
+	std::counting_semaphore<> m_signal{0};
+	// requests that did not fit in the submission ring.
+	std::deque<Request*> m_backlog{};
+	std::jthread m_thread{};
+};
+#endif
+
+// double buffered read-ahead: the next chunk is in flight while the current one is consumed.
+class AsyncFile : public IFile {
+  public:
+	AsyncFile(AsyncFile const&) = delete;
+	AsyncFile(AsyncFile&&) = delete;
+	auto operator=(AsyncFile const&) -> AsyncFile& = delete;
+	auto operator=(AsyncFile&&) -> AsyncFile& = delete;
+
+	explicit AsyncFile(std::shared_ptr<IoQueue> queue, std::unique_ptr<Handle> handle, std::uint32_t const chunk_size)
+		: m_queue(std::move(queue)), m_handle(std::move(handle)),
+		  m_charge(MemoryCategory::StreamBuffers, std::uint64_t(chunk_size) * m_chunks.size()) {
+		for (auto& chunk : m_chunks) {
+			chunk.data.resize(chunk_size);
+			chunk.request.handle = m_handle.get();
+		}
+		// decoders read the header right after opening.
+		issue(m_chunks.front(), 0);
+	}
+
+	~AsyncFile() override {
+		for (auto const& chunk : m_chunks) { chunk.request.wait(); }
+	}
+
+	[[nodiscard]] auto read(std::span<std::byte> out) -> std::size_t final {
+		m_failed = false;
+		auto ret = 0uz;
+		while (!out.empty() && m_position < m_handle->size) {
+			auto const* chunk = acquire_chunk();
+			if (chunk == nullptr) { break; }
+			auto const begin = std::size_t(m_position - chunk->offset);
+			auto const size = std::min(out.size(), chunk->size - begin);
+			std::memcpy(out.data(), chunk->data.data() + begin, size);
+			out = out.subspan(size);
+			m_position += size;
+			ret += size;
+		}
+		return ret;
+	}
+
+	[[nodiscard]] auto seek(std::int64_t const offset, SeekOrigin const origin) -> bool final {
+		auto const base = [&] {
+			switch (origin) {
+			case SeekOrigin::Current: return std::int64_t(m_position);
+			case SeekOrigin::End: return std::int64_t(m_handle->size);
+			default: return std::int64_t{};
+			}
+		}();
+		auto const target = base + offset;
+		if (target < 0 || std::uint64_t(target) > m_handle->size) { return false; }
+		m_position = std::uint64_t(target);
+		return true;
+	}
+
+	[[nodiscard]] auto tell() const -> std::uint64_t final { return m_position; }
+
+	[[nodiscard]] auto get_size() const -> std::uint64_t final { return m_handle->size; }
+
+	[[nodiscard]] auto has_failed() const -> bool final { return m_failed; }
+
+  private:
+	struct Chunk {
+		std::vector<std::byte> data{};
+		Request request{};
+		std::uint64_t offset{};
+		// valid bytes, once the request is done.
+		std::size_t size{};
+		bool issued{};
+	};
+
+	void issue(Chunk& chunk, std::uint64_t const offset) {
+		chunk.request.wait();
+		chunk.offset = offset;
+		chunk.size = 0;
+		chunk.issued = true;
+		auto const size = std::size_t(std::min(std::uint64_t(chunk.data.size()), m_handle->size - offset));
+		chunk.request.buffer = std::span{chunk.data}.subspan(0, size);
+		chunk.request.offset = offset;
+		m_queue->submit(chunk.request);
+	}
+
+	auto acquire_chunk() -> Chunk const* {
+		for (auto attempt = 0; attempt < 2; ++attempt) {
+			for (auto i = 0uz; i < m_chunks.size(); ++i) {
+				auto& chunk = m_chunks.at(i);
+				auto const end = chunk.offset + chunk.request.buffer.size();
+				if (!chunk.issued || m_position < chunk.offset || m_position >= end) { continue; }
+				chunk.request.wait();
+				chunk.size = chunk.request.bytes_read;
+				if (m_position >= chunk.offset + chunk.size) {
+					// short / failed read.
+					m_failed = chunk.request.failed;
+					chunk.issued = false;
+					return nullptr;
+				}
+				prefetch(m_chunks.at(1 - i), chunk.offset + chunk.size);
+				return &chunk;
+			}
+			// cold read after a seek: reuse the chunk that is not closest to being needed.
+			// the other chunk's prefetch may still be in flight: wait for it, so that reads of a file never overlap.
+			for (auto const& chunk : m_chunks) { chunk.request.wait(); }
+			issue(m_chunks.at(m_next_victim), m_position);
+			m_next_victim = 1 - m_next_victim;
+		}
+		return nullptr;
+	}
+
+	void prefetch(Chunk& chunk, std::uint64_t const offset) {
+		if (offset >= m_handle->size || (chunk.issued && chunk.offset == offset)) { return; }
+		issue(chunk, offset);
+	}
+
+	std::shared_ptr<IoQueue> m_queue{};
+	std::unique_ptr<Handle> m_handle{};
+	std::array<Chunk, 2> m_chunks{};
+	std::uint64_t m_position{};
+	std::size_t m_next_victim{};
+	bool m_failed{};
+	MemoryCharge m_charge;
+};
+
+class AsyncFileSystem : public IAsyncFileSystem {
+  public:
+	explicit AsyncFileSystem(std::shared_ptr<IoQueue> queue, std::uint32_t const chunk_size)
+		: m_queue(std::move(queue)), m_chunk_size(chunk_size) {}
+
+	[[nodiscard]] auto open(char const* path) -> std::unique_ptr<IFile> final {
+		if (path == nullptr || *path == '\0') { return {}; }
+		auto handle = m_queue->open(path);
+		if (!handle) { return {}; }
+		return std::make_unique<AsyncFile>(m_queue, std::move(handle), m_chunk_size);
+	}
+
+	[[nodiscard]] auto get_backend() const -> IoBackend final { return m_queue->get_backend(); }
+	[[nodiscard]] auto get_stats() const -> IoStats final { return m_queue->get_stats(); }
+
+  private:
+	std::shared_ptr<IoQueue> m_queue{};
+	std::uint32_t m_chunk_size{};
+};
+} // namespace
+} // namespace capo
+
+auto capo::create_async_file_system(AsyncFileSystemCreateInfo const& create_info) -> std::shared_ptr<IAsyncFileSystem> {
+	static constexpr auto min_chunk_size_v = 4u /*KiB*/ * 1024u /*B*/;
+	auto const chunk_size = std::max(create_info.chunk_size, min_chunk_size_v);
+#if defined(CAPO_IO_URING)
+	if (create_info.prefer_io_uring) {
+		auto queue = std::make_shared<IoUringQueue>();
+		if (queue->is_ready()) { return std::make_shared<AsyncFileSystem>(std::move(queue), chunk_size); }
+	}
+#endif
+	auto queue = std::make_shared<ThreadPoolQueue>(create_info.worker_count);
+	return std::make_shared<AsyncFileSystem>(std::move(queue), chunk_size);
+}
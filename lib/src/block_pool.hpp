@@ -0,0 +1,115 @@
+#pragma once
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <utility>
+
+namespace capo::detail {
+/// \brief Process-wide free list of fixed size blocks.
+/// Released blocks are kept for reuse instead of being returned to the heap,
+/// so that objects which are repeatedly created and destroyed stop allocating once warmed up.
+template <std::size_t Size, std::size_t Align>
+class BlockPool {
+  public:
+	BlockPool(BlockPool const&) = delete;
+	BlockPool(BlockPool&&) = delete;
+	auto operator=(BlockPool const&) -> BlockPool& = delete;
+	auto operator=(BlockPool&&) -> BlockPool& = delete;
+
+	[[nodiscard]] static auto get() -> BlockPool& {
+		// intentionally leaked: blocks may be released by static objects after this would be destroyed.
+		static auto* ret = new BlockPool{};
+		return *ret;
+	}
+
+	[[nodiscard]] auto allocate() -> void* {
+		{
+			auto lock = std::scoped_lock{m_mutex};
+			if (m_free != nullptr) { return std::exchange(m_free, m_free->next); }
+		}
+		return ::operator new(block_size_v, std::align_val_t{block_align_v});
+	}
+
+	void release(void* ptr) {
+		if (ptr == nullptr) { return; }
+		auto* node = ::new (ptr) Node{};
+		auto lock = std::scoped_lock{m_mutex};
+		node->next = std::exchange(m_free, node);
+	}
+
+  private:
+	struct Node {
+		Node* next{};
+	};
+
+	static constexpr auto block_size_v = Size < sizeof(Node) ? sizeof(Node) : Size;
+	static constexpr auto block_align_v = Align < alignof(Node) ? alignof(Node) : Align;
+
+	BlockPool() = default;
+	~BlockPool() = default;
+
+	std::mutex m_mutex{};
+	Node* m_free{};
+};
+
+/// \brief Allocator that serves single objects from a BlockPool, eg for std::allocate_shared().
+template <typename Type>
+class PoolAllocator {
+  public:
+	using value_type = Type;
+
+	PoolAllocator() = default;
+
+	template <typename Other>
+	PoolAllocator(PoolAllocator<Other> const& /*rhs*/) {}
+
+	[[nodiscard]] auto allocate(std::size_t const count) -> Type* {
+		if (count != 1) {
+			return static_cast<Type*>(::operator new(count * sizeof(Type), std::align_val_t{alignof(Type)}));
+		}
+		return static_cast<Type*>(pool_t::get().allocate());
+	}
+
+	void deallocate(Type* ptr, std::size_t const count) {
+		if (count != 1) {
+			::operator delete(ptr, std::align_val_t{alignof(Type)});
+			return;
+		}
+		pool_t::get().release(ptr);
+	}
+
+	template <typename Other>
+	auto operator==(PoolAllocator<Other> const& /*rhs*/) const -> bool {
+		return true;
+	}
+
+  private:
+	using pool_t = BlockPool<sizeof(Type), alignof(Type)>;
+};
+
+/// \brief std::make_shared() with the object (and control block) allocated from a BlockPool.
+template <typename Type, typename... Args>
+[[nodiscard]] auto make_pooled_shared(Args&&... args) -> std::shared_ptr<Type> {
+	return std::allocate_shared<Type>(PoolAllocator<Type>{}, std::forward<Args>(args)...);
+}
+
+/// \brief Mixin that allocates instances of Type (via new) from a BlockPool.
+/// Deleting via a pointer to a base works as long as the base has a virtual destructor.
+template <typename Type>
+class Pooled {
+  public:
+	[[nodiscard]] static auto operator new(std::size_t const size) -> void* {
+		if (size != sizeof(Type)) { return ::operator new(size); }
+		return BlockPool<sizeof(Type), alignof(Type)>::get().allocate();
+	}
+
+	static void operator delete(void* ptr, std::size_t const size) {
+		if (size != sizeof(Type)) {
+			::operator delete(ptr);
+			return;
+		}
+		BlockPool<sizeof(Type), alignof(Type)>::get().release(ptr);
+	}
+};
+} // namespace capo::detail
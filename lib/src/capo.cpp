@@ -1,7 +1,10 @@
 #include <miniaudio.h>
 #include <capo/buffer.hpp>
 #include <capo/engine.hpp>
+#include <capo/file_system.hpp>
 #include <capo/format.hpp>
+#include <capo/progressive_buffer.hpp>
+#include <capo/render_context.hpp>
 #include <capo/stream_pipe.hpp>
 #include <algorithm>
 #include <array>
@@ -12,13 +15,34 @@
 #include <cstdlib>
 #include <cstring>
 #include <filesystem>
-#include <fstream>
+#include <functional>
 #include <memory>
+#include <mutex>
 #include <optional>
 #include <ranges>
+#include <semaphore>
 #include <span>
+#include <stop_token>
+#include <string>
+#include <thread>
+#include <utility>
 #include <variant>
 #include <vector>
+#include "analyzer.hpp"
+#include "block_pool.hpp"
+#include "channel_mixer.hpp"
+#include "effect_graph.hpp"
+#include "ma_allocator.hpp"
+#include "ma_channel.hpp"
+#include "ma_encoding.hpp"
+#include "mix_group.hpp"
+#include "mpsc_queue.hpp"
+#include "output_capture.hpp"
+#include "parallel.hpp"
+#include "silence.hpp"
+#include "snapshot.hpp"
+#include "trace.hpp"
+#include "vfs.hpp"
 
 using namespace std::chrono_literals;
 
@@ -26,23 +50,54 @@ namespace fs = std::filesystem;
 
 namespace capo {
 namespace {
-constexpr auto to_ma_encoding(std::optional<Encoding> const encoding) -> ma_encoding_format {
-	if (!encoding) { return ma_encoding_format_unknown; }
-	switch (*encoding) {
-	case Encoding::Wav: return ma_encoding_format_wav;
-	case Encoding::Mp3: return ma_encoding_format_mp3;
-	case Encoding::Flac: return ma_encoding_format_flac;
-	default: return ma_encoding_format_unknown;
-	}
-}
-
 constexpr auto guess_encoding_from_extension(std::string_view const extension) -> std::optional<Encoding> {
 	if (extension == ".wav") { return Encoding::Wav; }
 	if (extension == ".mp3") { return Encoding::Mp3; }
 	if (extension == ".flac") { return Encoding::Flac; }
+	if (extension == ".ogg" || extension == ".oga") { return Encoding::Vorbis; }
+	if (extension == ".opus") { return Encoding::Opus; }
 	return {};
 }
 
+// falls back to the default map if the stream's map does not match its channel count.
+auto get_valid_channel_map(IStream const& stream) -> std::span<Channel const> {
+	auto const ret = stream.get_channel_map();
+	if (ret.size() != stream.get_channels()) { return get_default_channel_map(stream.get_channels()); }
+	return ret;
+}
+
+// consumes samples directly out of a stream's memory, if it supports acquire / release.
+// func is invoked with each acquired span of whole frames and the count of samples consumed so far.
+// returns nullopt if not supported.
+template <typename F>
+auto consume_samples(IStream& stream, std::size_t const max_count, std::size_t const channels, F func)
+	-> std::optional<std::size_t> {
+	auto ret = 0uz;
+	while (ret < max_count) {
+		auto samples = stream.acquire_samples(max_count - ret);
+		if (!samples) {
+			if (ret == 0) { return {}; }
+			break;
+		}
+		auto const count = std::min(samples->size(), max_count - ret);
+		samples = samples->subspan(0, count - (count % channels));
+		if (!samples->empty()) { func(*samples, ret); }
+		stream.release_samples(samples->size());
+		if (samples->empty()) { break; }
+		ret += samples->size();
+	}
+	return ret;
+}
+
+// mono and stereo in default layouts are left to miniaudio (which also spatializes them).
+auto should_mix_channels(std::span<Channel const> in_map, std::span<Channel const> out_map) -> bool {
+	if (in_map.empty() || out_map.empty()) { return false; }
+	if (in_map.size() <= 2 && std::ranges::equal(in_map, get_default_channel_map(std::uint8_t(in_map.size())))) {
+		return false;
+	}
+	return detail::ChannelMixer::is_required(in_map, out_map);
+}
+
 class Decoder : public ma_decoder {
   public:
 	Decoder(Decoder const&) = delete;
@@ -50,58 +105,81 @@ class Decoder : public ma_decoder {
 	auto operator=(Decoder const&) -> Decoder& = delete;
 	auto operator=(Decoder&&) -> Decoder& = delete;
 
-	explicit Decoder(std::span<std::byte const> bytes, std::optional<Encoding> const encoding) : ma_decoder({}) {
+	explicit Decoder(std::span<std::byte const> bytes, std::optional<Encoding> const encoding,
+					 detail::AllocatorContext& allocator)
+		: ma_decoder({}) {
+		CAPO_TRACE_SCOPE("Decoder::init");
 		auto config = ma_decoder_config_init(ma_format_f32, 0, Buffer::sample_rate_v);
-		config.encodingFormat = to_ma_encoding(encoding);
+		config.encodingFormat = detail::to_ma_encoding(encoding);
+		config.allocationCallbacks = detail::make_allocation_callbacks(&allocator);
+		detail::set_custom_backends(config);
 		auto result = ma_decoder_init_memory(bytes.data(), bytes.size(), &config, this);
 		if (result != MA_SUCCESS) {
 			failed = true;
 			return;
 		}
 
-		result = ma_decoder_get_data_format(this, nullptr, &config.channels, nullptr, nullptr, 0);
+		auto channel_map = std::array<ma_channel, MA_MAX_CHANNELS>{};
+		result = ma_decoder_get_data_format(this, nullptr, &config.channels, nullptr, channel_map.data(),
+											channel_map.size());
 		if (result != MA_SUCCESS) {
 			failed = true;
 			return;
 		}
 
 		m_channels = std::uint8_t(config.channels);
+		m_channel_map = detail::to_channel_map(std::span{channel_map}.subspan(0, config.channels));
 		m_input_size = bytes.size();
 	}
 
 	~Decoder() { ma_decoder_uninit(this); }
 
-	[[nodiscard]] auto decode(std::vector<float>& samples, std::uint8_t& channels) -> bool {
-		auto frames = ma_uint64{};
-		ma_decoder_get_length_in_pcm_frames(this, &frames);
-
+	[[nodiscard]] auto decode(std::pmr::vector<float>& samples, std::uint8_t& channels,
+							  std::vector<Channel>& channel_map) -> bool {
+		CAPO_TRACE_SCOPE("Decoder::decode");
 		channels = m_channels;
+		channel_map = m_channel_map;
 		samples.clear();
 		samples.reserve(get_reserve_size());
-		static constexpr auto buffer_size_v = 128uz /*KiB*/ * 1024uz /*B*/ / sizeof(float);
-		auto buffer = std::vector<float>(buffer_size_v);
+		static constexpr auto chunk_size_v = 128uz /*KiB*/ * 1024uz /*B*/ / sizeof(float);
 		while (true) {
-			auto const frames_to_read = buffer.size() / m_channels;
-			auto frames_read = ma_uint64{};
-			auto const result = ma_decoder_read_pcm_frames(this, buffer.data(), frames_to_read, &frames_read);
-			if (result != MA_SUCCESS || frames_read == 0) { return false; }
+			// decode straight into samples: into reserved capacity first, only growing once that runs out.
+			auto const offset = samples.size();
+			auto const spare = samples.capacity() - offset;
+			auto const count = spare >= m_channels ? spare : chunk_size_v;
+			samples.resize(offset + count - (count % m_channels));
 
-			auto const frames = std::span{buffer.data(), frames_read * m_channels};
-			for (auto const sample : frames) { samples.push_back(sample); }
+			auto const frames_to_read = (samples.size() - offset) / m_channels;
+			auto frames_read = ma_uint64{};
+			auto* out = samples.data() + offset;
+			auto const result = ma_decoder_read_pcm_frames(this, out, frames_to_read, &frames_read);
+			samples.resize(offset + (frames_read * m_channels));
+			if (result != MA_SUCCESS && result != MA_AT_END) { return false; }
 			if (frames_read < frames_to_read) { break; }
 		}
-		return true;
+		return !samples.empty();
+	}
+
+	// returns frames read, 0 if at end or on error.
+	[[nodiscard]] auto read(std::span<float> out) -> std::uint64_t {
+		auto frames_read = ma_uint64{};
+		ma_decoder_read_pcm_frames(this, out.data(), out.size() / m_channels, &frames_read);
+		return frames_read;
 	}
 
 	[[nodiscard]] auto get_channels() const -> std::uint8_t { return m_channels; }
+	[[nodiscard]] auto get_channel_map() const -> std::span<Channel const> { return m_channel_map; }
 
-	bool failed{};
+	// returns 0 if the decoder cannot report its length.
+	[[nodiscard]] auto get_frame_count() -> std::uint64_t {
+		auto ret = ma_uint64{};
+		if (ma_decoder_get_length_in_pcm_frames(this, &ret) != MA_SUCCESS) { return 0; }
+		return ret;
+	}
 
-  private:
 	[[nodiscard]] auto get_reserve_size() -> std::size_t {
-		auto frames = ma_uint64{};
 		// if the decoder returns the frame count, return exact value.
-		if (ma_decoder_get_length_in_pcm_frames(this, &frames) == MA_SUCCESS && frames > 0) {
+		if (auto const frames = get_frame_count(); frames > 0) {
 			// MP3s and FLACs decode one extra frame (?)...
 			return std::size_t((frames + 1) * m_channels);
 		}
@@ -115,6 +193,10 @@ class Decoder : public ma_decoder {
 		return std::min(input_based, max_reserve_v);
 	}
 
+	bool failed{};
+
+  private:
+	std::vector<Channel> m_channel_map{};
 	std::uint8_t m_channels{};
 	std::size_t m_input_size{};
 };
@@ -126,9 +208,10 @@ class AudioBuffer : public ma_audio_buffer {
 	auto operator=(AudioBuffer const&) -> AudioBuffer& = delete;
 	auto operator=(AudioBuffer&&) -> AudioBuffer& = delete;
 
-	explicit AudioBuffer(Buffer const& buffer) : ma_audio_buffer({}) {
-		auto config = ma_audio_buffer_config_init(ma_format_f32, buffer.get_channels(), buffer.get_frame_count(),
-												  buffer.get_samples().data(), nullptr);
+	// references samples, does not copy them.
+	explicit AudioBuffer(std::span<float const> samples, std::uint8_t const channels) : ma_audio_buffer({}) {
+		auto config =
+			ma_audio_buffer_config_init(ma_format_f32, channels, samples.size() / channels, samples.data(), nullptr);
 		config.sampleRate = Buffer::sample_rate_v;
 		auto result = ma_audio_buffer_init(&config, this);
 		if (result != MA_SUCCESS) {
@@ -145,6 +228,218 @@ class AudioBuffer : public ma_audio_buffer {
 	bool failed{};
 };
 
+// decoded samples are stored in chunks that double in size, so that they never move
+// and the chunk of any sample index can be computed without a lookup.
+// the first chunk fits the whole track if the decoder reports its length.
+class ProgressiveBuffer : public IProgressiveBuffer, public std::enable_shared_from_this<ProgressiveBuffer> {
+  public:
+	explicit ProgressiveBuffer(std::vector<std::byte> bytes, std::optional<Encoding> const encoding)
+		: m_bytes(std::move(bytes)), m_bytes_charge(MemoryCategory::EncodedData, m_bytes.size()),
+		  m_decoder(std::make_unique<Decoder>(m_bytes, encoding, m_allocator)) {
+		if (m_decoder->failed) { return; }
+		m_channels = m_decoder->get_channels();
+		auto const channel_map = m_decoder->get_channel_map();
+		m_channel_map.assign(channel_map.begin(), channel_map.end());
+		m_frame_count = m_decoder->get_frame_count();
+		auto const first_chunk_size = std::max(m_decoder->get_reserve_size(), std::size_t{Buffer::sample_rate_v});
+		m_first_chunk_size = (first_chunk_size / m_channels + 1) * m_channels;
+		m_thread = std::jthread{[this](std::stop_token const& stop) { decode(stop); }};
+	}
+
+	[[nodiscard]] auto has_failed() const -> bool { return m_channels == 0; }
+
+	[[nodiscard]] auto get_channels() const -> std::uint8_t final { return m_channels; }
+
+	[[nodiscard]] auto get_channel_map() const -> std::span<Channel const> final {
+		if (m_channel_map.size() != m_channels) { return get_default_channel_map(m_channels); }
+		return m_channel_map;
+	}
+
+	[[nodiscard]] auto get_frame_count() const -> std::uint64_t final {
+		auto const progress = m_progress.load(std::memory_order_acquire);
+		auto const decoded = get_frame_count(progress);
+		if (is_complete(progress)) { return decoded; }
+		return std::max(m_frame_count, decoded);
+	}
+
+	[[nodiscard]] auto get_decoded_frame_count() const -> std::uint64_t final {
+		return get_frame_count(m_progress.load(std::memory_order_acquire));
+	}
+
+	[[nodiscard]] auto is_complete() const -> bool final {
+		return is_complete(m_progress.load(std::memory_order_acquire));
+	}
+
+	void wait_for_frames(std::uint64_t const frame_count) const final {
+		auto progress = m_progress.load(std::memory_order_acquire);
+		while (!is_complete(progress) && get_frame_count(progress) < frame_count) {
+			m_progress.wait(progress, std::memory_order_acquire);
+			progress = m_progress.load(std::memory_order_acquire);
+		}
+	}
+
+	[[nodiscard]] auto create_stream() const -> std::shared_ptr<IStream> final;
+
+	// returns contiguous decoded samples starting at index, empty if not decoded (yet).
+	[[nodiscard]] auto get_samples(std::size_t const index, std::size_t const max_count) const
+		-> std::span<float const> {
+		auto const decoded = get_sample_count(m_progress.load(std::memory_order_acquire));
+		if (index >= decoded) { return {}; }
+		auto const chunk = get_chunk_index(index);
+		auto const offset = index - get_chunk_offset(chunk);
+		auto const count = std::min({get_chunk_size(chunk) - offset, decoded - index, max_count});
+		return std::span{m_chunks.at(chunk).samples.get() + offset, count};
+	}
+
+  private:
+	static constexpr auto max_chunks_v = 40uz;
+	static constexpr auto complete_bit_v = std::uint64_t{1} << 63;
+
+	struct Chunk {
+		std::unique_ptr<float[]> samples{};
+		MemoryCharge charge{};
+	};
+
+	[[nodiscard]] static constexpr auto is_complete(std::uint64_t const progress) -> bool {
+		return (progress & complete_bit_v) != 0;
+	}
+
+	[[nodiscard]] static constexpr auto get_sample_count(std::uint64_t const progress) -> std::size_t {
+		return std::size_t(progress & ~complete_bit_v);
+	}
+
+	[[nodiscard]] auto get_frame_count(std::uint64_t const progress) const -> std::uint64_t {
+		return get_sample_count(progress) / m_channels;
+	}
+
+	[[nodiscard]] auto get_chunk_index(std::size_t const index) const -> std::size_t {
+		return std::size_t(std::bit_width((index / m_first_chunk_size) + 1) - 1);
+	}
+
+	[[nodiscard]] auto get_chunk_offset(std::size_t const chunk) const -> std::size_t {
+		return m_first_chunk_size * ((1uz << chunk) - 1);
+	}
+
+	[[nodiscard]] auto get_chunk_size(std::size_t const chunk) const -> std::size_t {
+		return m_first_chunk_size << chunk;
+	}
+
+	void decode(std::stop_token const& stop) {
+		// small reads, to publish the first samples (and then progress) as soon as possible.
+		static constexpr auto read_frames_v = 4096uz;
+		auto decoded = 0uz;
+		while (!stop.stop_requested()) {
+			auto const chunk = get_chunk_index(decoded);
+			if (chunk >= max_chunks_v) { break; }
+			auto const chunk_size = get_chunk_size(chunk);
+			auto& samples = m_chunks.at(chunk).samples;
+			if (!samples) {
+				auto charge = MemoryCharge::try_create(MemoryCategory::DecodedPcm, chunk_size * sizeof(float));
+				if (!charge) { break; }
+				// pages are only touched as they are decoded into.
+				samples = std::make_unique_for_overwrite<float[]>(chunk_size);
+				m_chunks.at(chunk).charge = std::move(*charge);
+			}
+			auto const offset = decoded - get_chunk_offset(chunk);
+			auto const count = std::min(chunk_size - offset, read_frames_v * m_channels);
+			CAPO_TRACE_SCOPE("ProgressiveBuffer::decode");
+			auto const frames_read = m_decoder->read(std::span{samples.get() + offset, count});
+			if (frames_read == 0) { break; }
+			decoded += std::size_t(frames_read) * m_channels;
+			m_progress.store(decoded, std::memory_order_release);
+			m_progress.notify_all();
+		}
+
+		// encoded data is no longer needed.
+		m_decoder.reset();
+		m_bytes = {};
+		m_bytes_charge = {};
+		m_progress.store(decoded | complete_bit_v, std::memory_order_release);
+		m_progress.notify_all();
+	}
+
+	std::vector<std::byte> m_bytes{};
+	MemoryCharge m_bytes_charge{};
+	detail::AllocatorContext m_allocator{};
+	std::unique_ptr<Decoder> m_decoder{};
+
+	std::uint8_t m_channels{};
+	std::vector<Channel> m_channel_map{};
+	std::uint64_t m_frame_count{};
+	std::size_t m_first_chunk_size{};
+
+	std::array<Chunk, max_chunks_v> m_chunks{};
+	// decoded sample count | complete_bit_v.
+	std::atomic<std::uint64_t> m_progress{};
+
+	std::jthread m_thread{};
+};
+
+// each stream has its own cursor into a shared Progressive Buffer.
+class ProgressiveStream : public IStream {
+  public:
+	explicit ProgressiveStream(std::shared_ptr<ProgressiveBuffer const> buffer) : m_buffer(std::move(buffer)) {}
+
+	[[nodiscard]] auto get_sample_rate() const -> std::uint32_t final { return Buffer::sample_rate_v; }
+	[[nodiscard]] auto get_channels() const -> std::uint8_t final { return m_buffer->get_channels(); }
+	[[nodiscard]] auto get_channel_map() const -> std::span<Channel const> final {
+		return m_buffer->get_channel_map();
+	}
+
+	[[nodiscard]] auto read_samples(std::span<float> out) -> std::size_t final {
+		// check before reading: all samples are published by the time the buffer is complete.
+		auto const complete = m_buffer->is_complete();
+		auto cursor = m_cursor.load(std::memory_order_relaxed);
+		auto ret = 0uz;
+		while (ret < out.size()) {
+			auto const samples = m_buffer->get_samples(cursor, out.size() - ret);
+			if (samples.empty()) { break; }
+			std::ranges::copy(samples, out.begin() + std::ptrdiff_t(ret));
+			ret += samples.size();
+			cursor += samples.size();
+		}
+		m_cursor.store(cursor, std::memory_order_relaxed);
+		if (ret < out.size() && !complete) {
+			// underrun: pad with silence (without advancing) until the decoder catches up.
+			std::ranges::fill(out.subspan(ret), 0.0f);
+			return out.size();
+		}
+		return ret;
+	}
+
+	[[nodiscard]] auto acquire_samples(std::size_t const max_count) -> std::optional<std::span<float const>> final {
+		auto const complete = m_buffer->is_complete();
+		auto const ret = m_buffer->get_samples(m_cursor.load(std::memory_order_relaxed), max_count);
+		// on underrun fall back to read_samples(), which pads with silence.
+		if (ret.empty() && !complete) { return {}; }
+		return ret;
+	}
+
+	void release_samples(std::size_t const count) final { m_cursor.fetch_add(count, std::memory_order_relaxed); }
+
+	[[nodiscard]] auto seek_to_sample(std::size_t const index) -> bool final {
+		if (index > get_sample_count()) { return false; }
+		m_cursor.store(index - (index % get_channels()), std::memory_order_relaxed);
+		return true;
+	}
+
+	[[nodiscard]] auto get_cursor() const -> std::optional<std::size_t> final {
+		return m_cursor.load(std::memory_order_relaxed);
+	}
+
+	[[nodiscard]] auto get_sample_count() const -> std::size_t final {
+		return std::size_t(m_buffer->get_frame_count()) * get_channels();
+	}
+
+  private:
+	std::shared_ptr<ProgressiveBuffer const> m_buffer{};
+	std::atomic<std::size_t> m_cursor{};
+};
+
+auto ProgressiveBuffer::create_stream() const -> std::shared_ptr<IStream> {
+	return std::make_shared<ProgressiveStream>(shared_from_this());
+}
+
 class StreamSource : public ma_data_source_base {
   public:
 	StreamSource(StreamSource const&) = delete;
@@ -173,7 +468,12 @@ class StreamSource : public ma_data_source_base {
   private:
 	auto on_read(void* out, ma_uint64 count, ma_uint64& frames_read) {
 		auto const span = std::span{static_cast<float*>(out), std::size_t(count) * m_channels};
-		frames_read = ma_uint64(m_stream.read_samples(span) / m_channels);
+		auto const copy = [span](std::span<float const> in, std::size_t const offset) {
+			std::memcpy(span.subspan(offset).data(), in.data(), in.size_bytes());
+		};
+		auto samples_read = consume_samples(m_stream, span.size(), m_channels, copy);
+		if (!samples_read) { samples_read = m_stream.read_samples(span); }
+		frames_read = ma_uint64(*samples_read / m_channels);
 		if (frames_read == 0) { return MA_AT_END; }
 		return MA_SUCCESS;
 	}
@@ -191,13 +491,12 @@ class StreamSource : public ma_data_source_base {
 		fmt = ma_format_f32;
 		channels = ma_uint32(in_channels);
 		sample_rate = ma_uint32(in_sample_rate);
-		auto const span = std::span{ch_map, max_ch};
-		static constexpr auto channels_stereo_v = std::array{MA_CHANNEL_LEFT, MA_CHANNEL_RIGHT};
-		if (!span.empty()) {
-			if (channels == 1) {
-				span[0] = MA_CHANNEL_MONO;
+		if (ch_map != nullptr && max_ch > 0) {
+			auto const channel_map = get_valid_channel_map(m_stream);
+			if (channel_map.empty()) {
+				ma_channel_map_init_standard(ma_standard_channel_map_default, ch_map, max_ch, channels);
 			} else {
-				for (auto const [in, out] : std::views::zip(channels_stereo_v, span)) { out = in; }
+				detail::to_ma_channel_map(std::span{ch_map, max_ch}, channel_map);
 			}
 		}
 
@@ -210,7 +509,7 @@ class StreamSource : public ma_data_source_base {
 			out = 0;
 			return MA_NOT_IMPLEMENTED;
 		}
-		out = ma_uint64(*ret);
+		out = ma_uint64(*ret / m_channels);
 		return MA_SUCCESS;
 	}
 
@@ -220,7 +519,7 @@ class StreamSource : public ma_data_source_base {
 			out = 0;
 			return MA_NOT_IMPLEMENTED;
 		}
-		out = ma_uint64(ret * m_channels);
+		out = ma_uint64(ret / m_channels);
 		return MA_SUCCESS;
 	}
 
@@ -257,253 +556,1453 @@ ma_data_source_vtable const StreamSource::s_vtable = {
 	.flags = {},
 };
 
-class Sound : public ma_sound {
+class FileStream : public ma_resource_manager_data_source {
   public:
-	Sound(Sound const&) = delete;
-	Sound(Sound&&) = delete;
-	auto operator=(Sound const&) -> Sound& = delete;
-	auto operator=(Sound&&) -> Sound& = delete;
-
-	explicit Sound(ma_engine& engine, Buffer const& buffer)
-		: ma_sound({}), m_storage(std::in_place_type_t<AudioBuffer>{}, buffer) {
-		if (std::get<AudioBuffer>(m_storage).failed) {
+	FileStream(FileStream const&) = delete;
+	FileStream(FileStream&&) = delete;
+	auto operator=(FileStream const&) -> FileStream& = delete;
+	auto operator=(FileStream&&) -> FileStream& = delete;
+
+	explicit FileStream(ma_engine& engine, char const* path) : ma_resource_manager_data_source({}) {
+		static constexpr auto flags_v = MA_RESOURCE_MANAGER_DATA_SOURCE_FLAG_STREAM;
+		auto* resource_manager = ma_engine_get_resource_manager(&engine);
+		auto const result = ma_resource_manager_data_source_init(resource_manager, path, flags_v, nullptr, this);
+		if (result != MA_SUCCESS) {
 			failed = true;
 			return;
 		}
+	}
 
-		auto const result =
-			ma_sound_init_from_data_source(&engine, &std::get<AudioBuffer>(m_storage), 0, nullptr, this);
-		if (result != MA_SUCCESS) { failed = true; }
+	~FileStream() {
+		if (failed) { return; }
+		ma_resource_manager_data_source_uninit(this);
 	}
 
-	explicit Sound(ma_engine& engine, char const* path) : ma_sound({}) {
-		static constexpr auto flags_v = MA_SOUND_FLAG_STREAM;
-		auto const result = ma_sound_init_from_file(&engine, path, flags_v, nullptr, nullptr, this);
-		if (result != MA_SUCCESS) { failed = true; }
+	[[nodiscard]] auto get_channel_map() -> std::vector<Channel> {
+		auto channels = ma_uint32{};
+		auto channel_map = std::array<ma_channel, MA_MAX_CHANNELS>{};
+		auto const result =
+			ma_data_source_get_data_format(this, nullptr, &channels, nullptr, channel_map.data(), channel_map.size());
+		if (result != MA_SUCCESS) { return {}; }
+		return detail::to_channel_map(std::span{channel_map}.subspan(0, channels));
 	}
 
-	explicit Sound(ma_engine& engine, IStream& stream)
-		: ma_sound({}), m_storage(std::in_place_type_t<StreamSource>{}, stream) {
-		if (std::get<StreamSource>(m_storage).failed) {
+	bool failed{};
+};
+
+// routes a data source to the engine's channel layout, instead of miniaudio's generic
+// per-frame conversion which also ignores the source's channel map.
+class ChannelMixSource : public ma_data_source_base {
+  public:
+	ChannelMixSource(ChannelMixSource const&) = delete;
+	ChannelMixSource(ChannelMixSource&&) = delete;
+	auto operator=(ChannelMixSource const&) = delete;
+	auto operator=(ChannelMixSource&&) = delete;
+
+	explicit ChannelMixSource(ma_data_source* inner, std::span<Channel const> in_map, std::span<Channel const> out_map,
+							  IStream* stream = nullptr)
+		: ma_data_source_base({}), m_inner(inner), m_stream(stream), m_mixer(in_map, out_map),
+		  m_out_map(out_map.begin(), out_map.end()) {
+		static constexpr auto scratch_frames_v = 1024uz;
+		m_scratch.resize(scratch_frames_v * m_mixer.get_in_channels());
+		auto config = ma_data_source_config_init();
+		config.vtable = &s_vtable;
+		auto const result = ma_data_source_init(&config, this);
+		if (result != MA_SUCCESS) {
 			failed = true;
 			return;
 		}
-		auto const result =
-			ma_sound_init_from_data_source(&engine, &std::get<StreamSource>(m_storage), 0, nullptr, this);
-		if (result != MA_SUCCESS) { failed = true; }
 	}
 
-	~Sound() {
+	~ChannelMixSource() {
 		if (failed) { return; }
-		ma_sound_stop(this);
-		ma_sound_uninit(this);
+		ma_data_source_uninit(this);
 	}
 
 	bool failed{};
 
   private:
-	std::variant<std::monostate, AudioBuffer, StreamSource> m_storage{};
-};
-
-class Source : public ISource {
-  public:
-	explicit Source(ma_engine& engine) : m_engine(engine) {}
-
-	[[nodiscard]] auto is_bound() const -> bool final { return m_sound != nullptr; }
+	auto on_read(void* out, ma_uint64 const count, ma_uint64& frames_read) {
+		auto const in_channels = m_mixer.get_in_channels();
+		auto const out_channels = m_mixer.get_out_channels();
+		auto const out_span = std::span{static_cast<float*>(out), std::size_t(count) * out_channels};
+		if (m_stream != nullptr) {
+			// mix straight out of the stream's memory, skipping the scratch buffer.
+			auto const mix = [&](std::span<float const> in, std::size_t const offset) {
+				m_mixer.mix(in, out_span.subspan(offset / in_channels * out_channels));
+			};
+			auto const samples_read = consume_samples(*m_stream, std::size_t(count) * in_channels, in_channels, mix);
+			if (samples_read) {
+				frames_read = ma_uint64(*samples_read / in_channels);
+				return frames_read > 0 ? MA_SUCCESS : MA_AT_END;
+			}
+		}
 
-	auto bind_to(Buffer const* target) -> bool final {
-		if (target == nullptr || !target->is_loaded()) { return false; }
-		return try_create_sound(*target);
+		auto const max_frames = ma_uint64(m_scratch.size() / in_channels);
+		auto result = MA_SUCCESS;
+		frames_read = 0;
+		while (frames_read < count) {
+			auto const frames_to_read = std::min(count - frames_read, max_frames);
+			auto read = ma_uint64{};
+			result = ma_data_source_read_pcm_frames(m_inner, m_scratch.data(), frames_to_read, &read);
+			auto const in = std::span{m_scratch}.subspan(0, std::size_t(read) * in_channels);
+			m_mixer.mix(in, out_span.subspan(std::size_t(frames_read) * out_channels));
+			frames_read += read;
+			if (result != MA_SUCCESS || read < frames_to_read) { break; }
+		}
+		return frames_read > 0 ? MA_SUCCESS : result;
 	}
 
-	auto bind_to(std::shared_ptr<Buffer const> target) -> bool final {
-		if (!bind_to(target.get())) { return false; }
-		m_ref = std::move(target);
-		return true;
+	auto get_data_format(ma_format& fmt, ma_uint32& channels, ma_uint32& sample_rate, ma_channel* ch_map,
+						 std::size_t const max_ch) {
+		auto const result = ma_data_source_get_data_format(m_inner, nullptr, nullptr, &sample_rate, nullptr, 0);
+		if (result != MA_SUCCESS) { return result; }
+		fmt = ma_format_f32;
+		channels = ma_uint32(m_out_map.size());
+		if (ch_map != nullptr) { detail::to_ma_channel_map(std::span{ch_map, max_ch}, m_out_map); }
+		return MA_SUCCESS;
 	}
 
-	auto bind_to(IStream* target) -> bool final {
-		if (target == nullptr || target->get_channels() == 0 || target->get_sample_rate() == 0) { return false; }
-		return try_create_sound(*target);
-	}
+	static ma_data_source_vtable const s_vtable;
 
-	auto bind_to(std::shared_ptr<IStream> custom_stream) -> bool final {
-		if (!bind_to(custom_stream.get())) { return false; }
-		m_ref = std::move(custom_stream);
-		return true;
-	}
+	ma_data_source* m_inner{};
+	IStream* m_stream{};
+	detail::ChannelMixer m_mixer;
+	std::vector<Channel> m_out_map{};
+	std::vector<float> m_scratch{};
+};
 
-	auto open_file_stream(char const* path) -> bool final {
-		if (path == nullptr || *path == '\0') { return false; }
-		return try_create_sound(path);
-	}
+ma_data_source_vtable const ChannelMixSource::s_vtable = {
+	.onRead = [](ma_data_source* base, void* out, ma_uint64 count, ma_uint64* frames_read) -> ma_result {
+		return static_cast<ChannelMixSource*>(base)->on_read(out, count, *frames_read);
+	},
+	.onSeek = [](ma_data_source* base, ma_uint64 frame) -> ma_result {
+		return ma_data_source_seek_to_pcm_frame(static_cast<ChannelMixSource*>(base)->m_inner, frame);
+	},
+	.onGetDataFormat = [](ma_data_source* base, ma_format* fmt, ma_uint32* channels, ma_uint32* sample_rate,
+						  ma_channel* ch_map, std::size_t max_ch) -> ma_result {
+		return static_cast<ChannelMixSource*>(base)->get_data_format(*fmt, *channels, *sample_rate, ch_map, max_ch);
+	},
+	.onGetCursor = [](ma_data_source* base, ma_uint64* cursor) -> ma_result {
+		return ma_data_source_get_cursor_in_pcm_frames(static_cast<ChannelMixSource*>(base)->m_inner, cursor);
+	},
+	.onGetLength = [](ma_data_source* base, ma_uint64* out_length) -> ma_result {
+		return ma_data_source_get_length_in_pcm_frames(static_cast<ChannelMixSource*>(base)->m_inner, out_length);
+	},
+	.onSetLooping = [](ma_data_source* base, ma_bool32 loop) -> ma_result {
+		return ma_data_source_set_looping(static_cast<ChannelMixSource*>(base)->m_inner, loop);
+	},
+	.flags = {},
+};
 
-	void unbind() final {
-		m_sound.reset();
-		m_ref.reset();
-	}
+// outermost data source of every Sound: loops a region of the inner data source instead of all of it.
+// frames from the region's start are recorded into a cache as they play (once contiguous), so that wrapping around
+// is served from memory while the inner source seeks (for file streams that happens asynchronously).
+class LoopSource : public ma_data_source_base {
+  public:
+	LoopSource(LoopSource const&) = delete;
+	LoopSource(LoopSource&&) = delete;
+	auto operator=(LoopSource const&) = delete;
+	auto operator=(LoopSource&&) = delete;
 
-	[[nodiscard]] auto is_playing() const -> bool final {
-		return is_bound() && ma_sound_is_playing(m_sound.get()) == MA_TRUE;
+	explicit LoopSource(ma_data_source* inner) : ma_data_source_base({}), m_inner(inner) {
+		auto config = ma_data_source_config_init();
+		config.vtable = &s_vtable;
+		auto const result = ma_data_source_init(&config, this);
+		if (result != MA_SUCCESS) {
+			failed = true;
+			return;
+		}
+		auto sample_rate = ma_uint32{};
+		ma_data_source_get_data_format(inner, nullptr, &m_channels, &sample_rate, nullptr, 0);
+		m_cache_frames = sample_rate / 2;
 	}
 
-	void play() final {
-		if (!is_bound()) { return; }
-		m_ended.store(false);
-		ma_sound_start(m_sound.get());
+	~LoopSource() {
+		if (failed) { return; }
+		ma_data_source_uninit(this);
 	}
 
-	void stop() final {
-		if (!is_bound()) { return; }
-		ma_sound_stop(m_sound.get());
+	// must not be called concurrently with itself.
+	void set_region(std::optional<LoopRegion> const& region) {
+		if (region && !m_cache) {
+			auto const samples = std::size_t(m_cache_frames) * m_channels;
+			m_cache_storage = std::make_unique_for_overwrite<float[]>(samples);
+			m_cache_charge.resize(samples * sizeof(float));
+			m_cache.store(m_cache_storage.get(), std::memory_order_release);
+		}
+		m_has_region = region.has_value();
+		// the inner source must report its end instead of looping, when a region is looped.
+		ma_data_source_set_looping(m_inner, !m_has_region && ma_data_source_is_looping(this) ? MA_TRUE : MA_FALSE);
+		auto const generation = m_region.load().generation + 1;
+		m_region.store(Region{.start = region ? region->start : 0, .end = region ? region->end : 0,
+							  .generation = generation, .active = m_has_region});
 	}
 
-	[[nodiscard]] auto at_end() const -> bool final {
-		if (!is_bound()) { return true; }
-		return ma_sound_at_end(m_sound.get()) == MA_TRUE;
-	}
+	bool failed{};
 
-	[[nodiscard]] auto can_wait_until_ended() const -> bool final { return !is_looping() && is_playing(); }
+  private:
+	struct Region {
+		std::uint64_t start{};
+		std::uint64_t end{};
+		std::uint64_t generation{};
+		bool active{};
+	};
 
-	void wait_until_ended() final {
-		if (!can_wait_until_ended()) { return; }
-		m_ended.wait(false);
-	}
+	// the remaining members are only accessed on the audio thread.
+	auto on_read(void* out, ma_uint64 const count, ma_uint64& frames_read) -> ma_result {
+		sync_region();
+		auto const out_span = std::span{static_cast<float*>(out), std::size_t(count) * m_channels};
+		frames_read = 0;
+		if (!m_active.active || ma_data_source_is_looping(this) == MA_FALSE) {
+			m_serving.store(false, std::memory_order_relaxed);
+			return read_inner(out_span, frames_read);
+		}
 
-	[[nodiscard]] auto get_duration() const -> std::chrono::duration<float> final {
-		if (!is_bound()) { return -1s; }
-		return get_float(&ma_sound_get_length_in_seconds);
+		auto result = MA_SUCCESS;
+		auto empty_wraps = 0;
+		while (frames_read < count && empty_wraps < 2) {
+			auto const dst = out_span.subspan(std::size_t(frames_read) * m_channels);
+			if (m_serving.load(std::memory_order_relaxed)) {
+				frames_read += serve_cache(dst);
+				empty_wraps = 0;
+				continue;
+			}
+			auto cursor = ma_uint64{};
+			if (ma_data_source_get_cursor_in_pcm_frames(m_inner, &cursor) != MA_SUCCESS) { break; }
+			auto const end = m_active.end == 0 ? ~ma_uint64{} : m_active.end;
+			auto read = ma_uint64{};
+			if (cursor < end) {
+				auto const frames = std::min(count - frames_read, end - cursor);
+				result = read_inner(dst.subspan(0, std::size_t(frames) * m_channels), read);
+				frames_read += read;
+				if (result != MA_SUCCESS && result != MA_AT_END) { break; }
+				if (result == MA_SUCCESS && cursor + read < end) {
+					// short read before the end: let the next callback continue.
+					if (read < frames) { break; }
+					continue;
+				}
+			}
+			// reached the end of the region (or the data).
+			empty_wraps = read == 0 ? empty_wraps + 1 : 0;
+			wrap(cursor + read);
+		}
+		return frames_read > 0 ? MA_SUCCESS : result;
 	}
 
-	[[nodiscard]] auto get_cursor() const -> std::chrono::duration<float> final {
-		if (!is_bound()) { return -1s; }
-		return get_float(&ma_sound_get_cursor_in_seconds);
+	auto read_inner(std::span<float> out, ma_uint64& frames_read) -> ma_result {
+		auto cursor = ma_uint64{};
+		auto const has_cursor = ma_data_source_get_cursor_in_pcm_frames(m_inner, &cursor) == MA_SUCCESS;
+		auto const result = ma_data_source_read_pcm_frames(m_inner, out.data(), out.size() / m_channels, &frames_read);
+		if (has_cursor) { record(cursor, out.subspan(0, std::size_t(frames_read) * m_channels)); }
+		return result;
 	}
 
-	auto set_cursor(std::chrono::duration<float> const position) -> bool final {
-		if (!is_bound() || position < 0s || position > get_duration()) { return false; }
-		ma_sound_seek_to_second(m_sound.get(), position.count());
-		return true;
+	// copies frames that continue the cache (contiguously from the region's start).
+	void record(std::uint64_t const cursor, std::span<float const> frames) {
+		auto* cache = m_cache.load(std::memory_order_acquire);
+		if (cache == nullptr || !m_active.active || m_cached >= m_cache_frames) { return; }
+		auto const next = m_active.start + m_cached;
+		auto const frame_count = frames.size() / m_channels;
+		if (next < cursor || next >= cursor + frame_count) { return; }
+		auto const offset = std::size_t(next - cursor);
+		auto const count = std::min(frame_count - offset, std::size_t(m_cache_frames - m_cached));
+		std::ranges::copy(frames.subspan(offset * m_channels, count * m_channels), cache + (m_cached * m_channels));
+		m_cached += count;
 	}
 
-	[[nodiscard]] auto is_spatialized() const -> bool final {
-		return is_bound() && ma_sound_is_spatialization_enabled(m_sound.get()) == MA_TRUE;
+	auto serve_cache(std::span<float> out) -> ma_uint64 {
+		auto const* cache = m_cache.load(std::memory_order_acquire);
+		auto const served = m_served.load(std::memory_order_relaxed);
+		auto const count = std::min(out.size() / m_channels, std::size_t(m_cached - served));
+		std::copy_n(cache + (served * m_channels), count * m_channels, out.begin());
+		m_served.store(served + count, std::memory_order_relaxed);
+		if (served + count == m_cached) { m_serving.store(false, std::memory_order_relaxed); }
+		return count;
 	}
 
-	auto set_spatialized(bool const spatialized) -> bool final {
-		if (!is_bound()) { return false; }
-		ma_sound_set_spatialization_enabled(m_sound.get(), spatialized ? MA_TRUE : MA_FALSE);
-		return true;
+	void wrap(std::uint64_t const cursor) {
+		// the cache can be played if it is full, or if it was recorded right up to the end.
+		auto const usable = m_cached > 0 && (m_cached == m_cache_frames || m_active.start + m_cached == cursor);
+		if (!usable) {
+			m_cached = 0;
+			ma_data_source_seek_to_pcm_frame(m_inner, m_active.start);
+			return;
+		}
+		m_served.store(0, std::memory_order_relaxed);
+		m_served_start.store(m_active.start, std::memory_order_relaxed);
+		m_serving.store(true, std::memory_order_relaxed);
+		ma_data_source_seek_to_pcm_frame(m_inner, m_active.start + m_cached);
 	}
 
-	auto set_fade_in(std::chrono::duration<float> duration, float const gain) -> bool final {
-		if (!is_bound()) { return false; }
-		ma_sound_set_fade_in_milliseconds(m_sound.get(), 0.0f, gain, to_ms(duration));
-		return true;
+	// never waits on a concurrent set_region(): keeps the active region and retries on the next callback.
+	void sync_region() {
+		auto const region = m_region.try_load();
+		if (!region || region->generation == m_active.generation) { return; }
+		m_active = *region;
+		m_cached = 0;
+		m_serving.store(false, std::memory_order_relaxed);
 	}
 
-	auto set_fade_out(std::chrono::duration<float> duration) -> bool final {
-		if (!is_bound()) { return false; }
-		ma_sound_set_fade_in_milliseconds(m_sound.get(), -1.0f, 0.0f, to_ms(duration));
-		return true;
+	auto on_seek(ma_uint64 const frame) -> ma_result {
+		m_serving.store(false, std::memory_order_relaxed);
+		return ma_data_source_seek_to_pcm_frame(m_inner, frame);
 	}
 
-	[[nodiscard]] auto is_looping() const -> bool final { return m_state.looping; }
-
-	void set_looping(bool const looping) final {
-		m_state.looping = looping;
-		if (!is_bound()) { return; }
-		ma_sound_set_looping(m_sound.get(), looping ? MA_TRUE : MA_FALSE);
+	auto get_cursor(ma_uint64& out) const -> ma_result {
+		if (m_serving.load(std::memory_order_relaxed)) {
+			out = m_served_start.load(std::memory_order_relaxed) + m_served.load(std::memory_order_relaxed);
+			return MA_SUCCESS;
+		}
+		return ma_data_source_get_cursor_in_pcm_frames(m_inner, &out);
 	}
 
-	[[nodiscard]] auto get_gain() const -> float final { return m_state.gain; }
-
-	void set_gain(float const gain) final {
-		m_state.gain = std::clamp(gain, 0.0f, 1.0f);
-		if (!is_bound()) { return; }
-		ma_sound_set_volume(m_sound.get(), m_state.gain);
+	auto set_looping(ma_bool32 const loop) -> ma_result {
+		if (m_has_region) { return MA_SUCCESS; }
+		return ma_data_source_set_looping(m_inner, loop);
 	}
 
-	[[nodiscard]] auto get_position() const -> Vec3f final { return m_state.position; }
+	static ma_data_source_vtable const s_vtable;
+
+	ma_data_source* m_inner{};
+	ma_uint32 m_channels{};
+	ma_uint32 m_cache_frames{};
+	std::unique_ptr<float[]> m_cache_storage{};
+	MemoryCharge m_cache_charge{MemoryCategory::StreamBuffers, 0};
+	bool m_has_region{};
+
+	detail::Snapshot<Region> m_region{};
+	std::atomic<float*> m_cache{};
+	std::atomic_bool m_serving{};
+	std::atomic<std::uint64_t> m_served{};
+	// start of the region being served, the cursor is read without touching m_region.
+	std::atomic<std::uint64_t> m_served_start{};
+
+	Region m_active{};
+	std::uint64_t m_cached{};
+};
+
+ma_data_source_vtable const LoopSource::s_vtable = {
+	.onRead = [](ma_data_source* base, void* out, ma_uint64 count, ma_uint64* frames_read) -> ma_result {
+		return static_cast<LoopSource*>(base)->on_read(out, count, *frames_read);
+	},
+	.onSeek = [](ma_data_source* base, ma_uint64 frame) -> ma_result {
+		return static_cast<LoopSource*>(base)->on_seek(frame);
+	},
+	.onGetDataFormat = [](ma_data_source* base, ma_format* fmt, ma_uint32* channels, ma_uint32* sample_rate,
+						  ma_channel* ch_map, std::size_t max_ch) -> ma_result {
+		auto* inner = static_cast<LoopSource*>(base)->m_inner;
+		return ma_data_source_get_data_format(inner, fmt, channels, sample_rate, ch_map, max_ch);
+	},
+	.onGetCursor = [](ma_data_source* base, ma_uint64* cursor) -> ma_result {
+		return static_cast<LoopSource*>(base)->get_cursor(*cursor);
+	},
+	.onGetLength = [](ma_data_source* base, ma_uint64* out_length) -> ma_result {
+		return ma_data_source_get_length_in_pcm_frames(static_cast<LoopSource*>(base)->m_inner, out_length);
+	},
+	.onSetLooping = [](ma_data_source* base, ma_bool32 loop) -> ma_result {
+		return static_cast<LoopSource*>(base)->set_looping(loop);
+	},
+	// looping within the region is handled here, miniaudio only loops (by seeking to 0) when there is none.
+	.flags = MA_DATA_SOURCE_SELF_MANAGED_RANGE_AND_LOOP_POINT,
+};
+
+class Sound : public ma_sound, public detail::Pooled<Sound> {
+  public:
+	Sound(Sound const&) = delete;
+	Sound(Sound&&) = delete;
+	auto operator=(Sound const&) -> Sound& = delete;
+	auto operator=(Sound&&) -> Sound& = delete;
+
+	explicit Sound(ma_engine& engine, Buffer const& buffer)
+		: ma_sound({}), m_storage(std::in_place_type_t<AudioBuffer>{}, buffer.get_samples(), buffer.get_channels()) {
+		if (std::get<AudioBuffer>(m_storage).failed) {
+			failed = true;
+			return;
+		}
+		init(engine, &std::get<AudioBuffer>(m_storage), buffer.get_channel_map());
+	}
+
+	explicit Sound(ma_engine& engine, BufferView const& view)
+		: ma_sound({}), m_storage(std::in_place_type_t<AudioBuffer>{}, view.get_samples(), view.get_channels()) {
+		if (std::get<AudioBuffer>(m_storage).failed) {
+			failed = true;
+			return;
+		}
+		init(engine, &std::get<AudioBuffer>(m_storage), view.get_channel_map());
+	}
+
+	explicit Sound(ma_engine& engine, char const* path)
+		: ma_sound({}), m_storage(std::in_place_type_t<FileStream>{}, engine, path) {
+		auto& file_stream = std::get<FileStream>(m_storage);
+		if (file_stream.failed) {
+			failed = true;
+			return;
+		}
+		init(engine, &file_stream, file_stream.get_channel_map());
+	}
+
+	explicit Sound(ma_engine& engine, IStream& stream)
+		: ma_sound({}), m_storage(std::in_place_type_t<StreamSource>{}, stream) {
+		if (std::get<StreamSource>(m_storage).failed) {
+			failed = true;
+			return;
+		}
+		init(engine, &std::get<StreamSource>(m_storage), get_valid_channel_map(stream), &stream);
+	}
+
+	~Sound() {
+		if (failed) { return; }
+		ma_sound_stop(this);
+		ma_sound_uninit(this);
+	}
+
+	void set_loop_region(std::optional<LoopRegion> const& region) { m_loop->set_region(region); }
+
+	bool failed{};
+
+  private:
+	void init(ma_engine& engine, ma_data_source* source, std::span<Channel const> channel_map,
+			  IStream* stream = nullptr) {
+		CAPO_TRACE_SCOPE("Sound::init");
+		auto* data_source = source;
+		auto const out_map = get_default_channel_map(std::uint8_t(ma_engine_get_channels(&engine)));
+		if (should_mix_channels(channel_map, out_map)) {
+			auto& mixer = m_mixer.emplace(source, channel_map, out_map, stream);
+			if (mixer.failed) {
+				failed = true;
+				return;
+			}
+			data_source = &mixer;
+		}
+		auto& loop = m_loop.emplace(data_source);
+		if (loop.failed) {
+			failed = true;
+			return;
+		}
+		auto const result = ma_sound_init_from_data_source(&engine, &loop, 0, nullptr, this);
+		if (result != MA_SUCCESS) { failed = true; }
+	}
+
+	std::variant<std::monostate, AudioBuffer, StreamSource, FileStream> m_storage{};
+	std::optional<ChannelMixSource> m_mixer{};
+	std::optional<LoopSource> m_loop{};
+};
+
+// plays samples out of a Buffer, restarted (without reinitializing its Sound) for each one-shot.
+// the channel map is fixed while bound to a Sound.
+class VoiceStream : public IStream {
+  public:
+	void set_channel_map(std::span<Channel const> channel_map) {
+		m_channel_map.assign(channel_map.begin(), channel_map.end());
+	}
+
+	// must only be called from one thread at a time.
+	void set_samples(std::span<float const> samples) {
+		m_clip.store(Clip{.data = samples.data(), .size = samples.size(), .generation = ++m_generation});
+	}
+
+	[[nodiscard]] auto get_sample_rate() const -> std::uint32_t final { return Buffer::sample_rate_v; }
+	[[nodiscard]] auto get_channels() const -> std::uint8_t final { return std::uint8_t(m_channel_map.size()); }
+	[[nodiscard]] auto get_channel_map() const -> std::span<Channel const> final { return m_channel_map; }
+
+	[[nodiscard]] auto read_samples(std::span<float> out) -> std::size_t final {
+		auto const samples = *acquire_samples(out.size());
+		std::ranges::copy(samples, out.begin());
+		release_samples(samples.size());
+		return samples.size();
+	}
+
+	[[nodiscard]] auto acquire_samples(std::size_t const max_count) -> std::optional<std::span<float const>> final {
+		update_clip();
+		auto const cursor = std::min(std::size_t(m_cursor.load(std::memory_order_relaxed)), m_current.size);
+		return std::span{m_current.data + cursor, std::min(max_count, m_current.size - cursor)};
+	}
+
+	void release_samples(std::size_t const count) final { m_cursor.fetch_add(count, std::memory_order_relaxed); }
+
+	[[nodiscard]] auto seek_to_sample(std::size_t const index) -> bool final {
+		m_cursor.store(index, std::memory_order_relaxed);
+		return true;
+	}
+
+	[[nodiscard]] auto get_cursor() const -> std::optional<std::size_t> final {
+		return m_cursor.load(std::memory_order_relaxed);
+	}
+
+	[[nodiscard]] auto get_sample_count() const -> std::size_t final { return m_clip.load().size; }
+
+  private:
+	struct Clip {
+		float const* data{};
+		std::size_t size{};
+		std::uint64_t generation{};
+	};
+
+	// called on the audio thread: a new clip restarts playback from its beginning.
+	// never waits on a concurrent set_samples(): keeps the current clip and retries on the next callback.
+	void update_clip() {
+		auto const clip = m_clip.try_load();
+		if (!clip || clip->generation == m_current.generation) { return; }
+		m_current = *clip;
+		m_cursor.store(0, std::memory_order_relaxed);
+	}
+
+	std::vector<Channel> m_channel_map{};
+	detail::Snapshot<Clip> m_clip{};
+	std::uint64_t m_generation{};
+
+	Clip m_current{};
+	std::atomic<std::size_t> m_cursor{};
+};
+
+struct Voice {
+	[[nodiscard]] auto is_busy() const -> bool {
+		return sound && ma_sound_is_playing(sound.get()) == MA_TRUE && ma_sound_at_end(sound.get()) == MA_FALSE;
+	}
+
+	auto init(ma_engine& engine, std::span<Channel const> channel_map) -> bool {
+		stream.set_channel_map(channel_map);
+		auto ret = std::make_unique<Sound>(engine, stream);
+		if (ret->failed) { return false; }
+		sound = std::move(ret);
+		return true;
+	}
+
+	VoiceStream stream{};
+	std::unique_ptr<Sound> sound{};
+	std::uint64_t sequence{};
+	float gain{};
+	std::int32_t priority{};
+};
+
+// voices of one channel layout: once initialized, a voice is never reinitialized.
+struct VoiceBank {
+	explicit VoiceBank(std::span<Channel const> channel_map, std::uint32_t const count)
+		: channel_map(channel_map.begin(), channel_map.end()), voices(count) {}
+
+	std::vector<Channel> channel_map;
+	std::vector<Voice> voices;
+};
+
+// fixed set of voices per channel layout that one-shots are played on.
+class VoicePool {
+  public:
+	explicit VoicePool(ma_engine& engine, std::uint32_t const count, StealPolicy const policy)
+		: m_engine(engine), m_count(count), m_policy(policy) {
+		// mono and stereo are preallocated (initialized by warm_up()), other layouts get a bank on first use.
+		m_banks.reserve(4);
+		m_banks.emplace_back(get_default_channel_map(1), count);
+		m_banks.emplace_back(get_default_channel_map(2), count);
+	}
+
+	auto play(Buffer const& buffer, OneShotParams const& params) -> bool {
+		if (!buffer.is_loaded()) { return false; }
+		auto lock = std::scoped_lock{m_mutex};
+		auto* voice = acquire(get_bank(buffer.get_channel_map()), params.priority);
+		if (voice == nullptr) { return false; }
+
+		auto* sound = voice->sound.get();
+		ma_sound_stop(sound);
+		voice->stream.set_samples(buffer.get_samples());
+		voice->sequence = ++m_sequence;
+		voice->gain = std::clamp(params.gain, 0.0f, 1.0f);
+		voice->priority = params.priority;
+		ma_sound_set_volume(sound, voice->gain);
+		ma_sound_set_pan(sound, params.pan);
+		ma_sound_set_pitch(sound, std::max(params.pitch, 0.0f));
+		ma_sound_set_position(sound, params.position.x, params.position.y, params.position.z);
+		ma_sound_set_spatialization_enabled(sound, params.spatialized ? MA_TRUE : MA_FALSE);
+		ma_node_attach_output_bus(sound, 0, detail::get_input_node(m_engine, params.output), 0);
+		ma_sound_start(sound);
+		return true;
+	}
+
+	[[nodiscard]] auto get_active_count() const -> std::uint32_t {
+		auto lock = std::scoped_lock{m_mutex};
+		auto ret = 0u;
+		for (auto const& bank : m_banks) { ret += std::uint32_t(std::ranges::count_if(bank.voices, &Voice::is_busy)); }
+		return ret;
+	}
+
+	void stop_all() {
+		auto lock = std::scoped_lock{m_mutex};
+		for (auto const& bank : m_banks) {
+			for (auto const& voice : bank.voices) {
+				if (voice.sound) { ma_sound_stop(voice.sound.get()); }
+			}
+		}
+	}
+
+	// initializes all voices of the preallocated banks, one per lock so that play() is not held up meanwhile.
+	void warm_up() {
+		for (auto b = 0uz; b < preallocated_banks_v; ++b) {
+			for (auto v = 0uz; v < m_count; ++v) {
+				auto lock = std::scoped_lock{m_mutex};
+				auto& voice = m_banks.at(b).voices.at(v);
+				if (!voice.sound) { voice.init(m_engine, m_banks.at(b).channel_map); }
+			}
+		}
+	}
+
+  private:
+	static constexpr auto preallocated_banks_v = 2uz;
+
+	auto get_bank(std::span<Channel const> channel_map) -> VoiceBank& {
+		for (auto& bank : m_banks) {
+			if (std::ranges::equal(bank.channel_map, channel_map)) { return bank; }
+		}
+		return m_banks.emplace_back(channel_map, m_count);
+	}
+
+	// idle voices that are already initialized are preferred.
+	auto acquire(VoiceBank& bank, std::int32_t const priority) -> Voice* {
+		auto* ret = static_cast<Voice*>(nullptr);
+		for (auto& voice : bank.voices) {
+			if (voice.is_busy()) { continue; }
+			if (voice.sound) { return &voice; }
+			if (ret == nullptr) { ret = &voice; }
+		}
+		if (ret == nullptr) { ret = steal(bank, priority); }
+		if (ret == nullptr) { return nullptr; }
+		if (!ret->sound && !ret->init(m_engine, bank.channel_map)) { return nullptr; }
+		return ret;
+	}
+
+	auto steal(VoiceBank& bank, std::int32_t const priority) -> Voice* {
+		if (m_policy == StealPolicy::None) { return nullptr; }
+		auto* ret = static_cast<Voice*>(nullptr);
+		for (auto& voice : bank.voices) {
+			if (voice.priority > priority) { continue; }
+			if (ret == nullptr || should_steal_first(voice, *ret)) { ret = &voice; }
+		}
+		return ret;
+	}
+
+	[[nodiscard]] auto should_steal_first(Voice const& a, Voice const& b) const -> bool {
+		if (a.priority != b.priority) { return a.priority < b.priority; }
+		if (m_policy == StealPolicy::Quietest && a.gain != b.gain) { return a.gain < b.gain; }
+		return a.sequence < b.sequence;
+	}
+
+	ma_engine& m_engine;
+	std::uint32_t m_count{};
+	// banks may move, their voices do not (sounds point to their streams).
+	std::vector<VoiceBank> m_banks{};
+	StealPolicy m_policy{};
+
+	mutable std::mutex m_mutex{};
+	std::uint64_t m_sequence{};
+};
+
+// timestamps each audio callback, so that playback positions can be interpolated in between.
+class PlaybackTimer {
+  public:
+	explicit PlaybackTimer(ma_engine& engine) : m_engine(&engine) {}
+
+	// must be called after the engine is initialized (but the device may already be running).
+	void init() {
+		m_sample_rate = ma_engine_get_sample_rate(m_engine);
+		if (auto const* device = ma_engine_get_device(m_engine)) { set_device(*device); }
+	}
+
+	// called once the device of a lazily started engine is initialized.
+	void set_device(ma_device const& device) {
+		if (device.playback.internalSampleRate == 0) { return; }
+		// each callback renders one period, which is audible after the periods queued ahead of it have played.
+		auto const frames = device.playback.internalPeriodSizeInFrames * device.playback.internalPeriods;
+		m_latency.store(double(frames) / double(device.playback.internalSampleRate));
+	}
+
+	// called on the audio thread, after each block is mixed.
+	void on_process(std::uint64_t const block_frames) {
+		auto const frames = ma_engine_get_time_in_pcm_frames(m_engine);
+		m_stamp.store(Stamp{.frames = frames, .time = PlaybackClock::clock_t::now(), .block_frames = block_frames});
+	}
+
+	// duration of the last block: what mix groups render ahead by.
+	[[nodiscard]] auto get_block_duration() const -> std::chrono::duration<double> {
+		if (m_sample_rate == 0) { return {}; }
+		return std::chrono::duration<double>{double(m_stamp.load().block_frames) / double(m_sample_rate)};
+	}
+
+	[[nodiscard]] auto get_engine_clock() const -> PlaybackClock {
+		auto const stamp = m_stamp.load();
+		return PlaybackClock{
+			.frames = stamp.frames,
+			.sample_rate = m_sample_rate,
+			.rate = 1.0f,
+			.callback_time = stamp.time,
+			.latency = get_latency(),
+		};
+	}
+
+	// func returns a clock with frames, sample_rate and rate filled in.
+	// it is retried if a callback is processed in between, to pair it with the right timestamp.
+	template <typename F>
+	[[nodiscard]] auto sample(F func) const -> PlaybackClock {
+		auto ret = PlaybackClock{};
+		for (auto attempt = 0; attempt < max_attempts_v; ++attempt) {
+			auto const version = m_stamp.get_version();
+			ret = func();
+			ret.callback_time = m_stamp.load().time;
+			if (m_stamp.get_version() == version) { break; }
+		}
+		ret.latency = get_latency();
+		return ret;
+	}
+
+  private:
+	struct Stamp {
+		std::uint64_t frames{};
+		PlaybackClock::clock_t::time_point time{};
+		std::uint64_t block_frames{};
+	};
+
+	static constexpr auto max_attempts_v = 4;
+
+	[[nodiscard]] auto get_latency() const -> std::chrono::duration<double> {
+		return std::chrono::duration<double>{m_latency.load()};
+	}
+
+	ma_engine* m_engine{};
+	std::uint32_t m_sample_rate{};
+	std::atomic<double> m_latency{};
+	detail::Snapshot<Stamp> m_stamp{};
+};
+
+// runs the startup of a lazily started device on a background thread, once requested.
+class DeviceStarter {
+  public:
+	explicit DeviceStarter(std::function<void()> start) : m_start(std::move(start)) {}
+
+	void request() {
+		std::call_once(m_once, [this] { m_thread = std::jthread{m_start}; });
+	}
+
+	// waits for startup if requested, and prevents any further requests.
+	void join() {
+		std::call_once(m_once, [] {});
+		if (m_thread.joinable()) { m_thread.join(); }
+	}
+
+  private:
+	std::function<void()> m_start;
+	std::once_flag m_once{};
+	std::jthread m_thread{};
+};
+
+class Source : public ISource, public detail::Pooled<Source> {
+  public:
+	explicit Source(ma_engine& engine, PlaybackTimer const& timer, DeviceStarter* starter = nullptr)
+		: m_engine(engine), m_timer(timer), m_starter(starter) {}
+
+	[[nodiscard]] auto is_bound() const -> bool final { return m_sound != nullptr; }
+
+	auto bind_to(Buffer const* target) -> bool final {
+		if (target == nullptr || !target->is_loaded()) { return false; }
+		return try_create_sound(*target);
+	}
+
+	auto bind_to(std::shared_ptr<Buffer const> target) -> bool final {
+		if (!bind_to(target.get())) { return false; }
+		m_ref = std::move(target);
+		return true;
+	}
+
+	auto bind_to(BufferView const& target) -> bool final {
+		if (!target.is_loaded() || !try_create_sound(target)) { return false; }
+		m_ref = target.get_buffer();
+		return true;
+	}
+
+	auto bind_to(IStream* target) -> bool final {
+		if (target == nullptr || target->get_channels() == 0 || target->get_sample_rate() == 0) { return false; }
+		return try_create_sound(*target);
+	}
+
+	auto bind_to(std::shared_ptr<IStream> custom_stream) -> bool final {
+		if (!bind_to(custom_stream.get())) { return false; }
+		m_ref = std::move(custom_stream);
+		return true;
+	}
+
+	auto open_file_stream(char const* path) -> bool final {
+		if (path == nullptr || *path == '\0') { return false; }
+		return try_create_sound(path);
+	}
+
+	void unbind() final {
+		m_sound.reset();
+		m_ref.reset();
+	}
+
+	[[nodiscard]] auto is_playing() const -> bool final {
+		return is_bound() && ma_sound_is_playing(m_sound.get()) == MA_TRUE;
+	}
+
+	void play() final {
+		if (!is_bound()) { return; }
+		m_ended.store(false);
+		ma_sound_start(m_sound.get());
+		if (m_starter != nullptr) { m_starter->request(); }
+	}
+
+	void stop() final {
+		if (!is_bound()) { return; }
+		ma_sound_stop(m_sound.get());
+	}
+
+	[[nodiscard]] auto at_end() const -> bool final {
+		if (!is_bound()) { return true; }
+		return ma_sound_at_end(m_sound.get()) == MA_TRUE;
+	}
+
+	[[nodiscard]] auto can_wait_until_ended() const -> bool final { return !is_looping() && is_playing(); }
+
+	void wait_until_ended() final {
+		if (!can_wait_until_ended()) { return; }
+		m_ended.wait(false);
+	}
+
+	[[nodiscard]] auto get_duration() const -> std::chrono::duration<float> final {
+		if (!is_bound()) { return -1s; }
+		return get_float(&ma_sound_get_length_in_seconds);
+	}
+
+	[[nodiscard]] auto get_cursor() const -> std::chrono::duration<float> final {
+		if (!is_bound()) { return -1s; }
+		return get_float(&ma_sound_get_cursor_in_seconds);
+	}
+
+	[[nodiscard]] auto get_clock() const -> PlaybackClock final {
+		if (!is_bound()) { return {}; }
+		auto ret = m_timer.sample([this] {
+			auto ret = PlaybackClock{};
+			auto cursor = ma_uint64{};
+			ma_sound_get_cursor_in_pcm_frames(m_sound.get(), &cursor);
+			ret.frames = cursor;
+			ma_sound_get_data_format(m_sound.get(), nullptr, nullptr, &ret.sample_rate, nullptr, 0);
+			ret.rate = ma_sound_is_playing(m_sound.get()) == MA_TRUE ? ma_sound_get_pitch(m_sound.get()) : 0.0f;
+			return ret;
+		});
+		// grouped Sources are mixed ahead of the audio thread.
+		if (m_state.mix_group != nullptr) { ret.latency += m_timer.get_block_duration(); }
+		return ret;
+	}
+
+	auto set_cursor(std::chrono::duration<float> const position) -> bool final {
+		if (!is_bound() || position < 0s || position > get_duration()) { return false; }
+		ma_sound_seek_to_second(m_sound.get(), position.count());
+		return true;
+	}
+
+	[[nodiscard]] auto is_spatialized() const -> bool final {
+		return is_bound() && ma_sound_is_spatialization_enabled(m_sound.get()) == MA_TRUE;
+	}
+
+	auto set_spatialized(bool const spatialized) -> bool final {
+		if (!is_bound()) { return false; }
+		ma_sound_set_spatialization_enabled(m_sound.get(), spatialized ? MA_TRUE : MA_FALSE);
+		return true;
+	}
+
+	auto set_fade_in(std::chrono::duration<float> duration, float const gain) -> bool final {
+		if (!is_bound()) { return false; }
+		ma_sound_set_fade_in_milliseconds(m_sound.get(), 0.0f, gain, to_ms(duration));
+		return true;
+	}
+
+	auto set_fade_out(std::chrono::duration<float> duration) -> bool final {
+		if (!is_bound()) { return false; }
+		ma_sound_set_fade_in_milliseconds(m_sound.get(), -1.0f, 0.0f, to_ms(duration));
+		return true;
+	}
+
+	[[nodiscard]] auto is_looping() const -> bool final { return m_state.looping; }
+
+	void set_looping(bool const looping) final {
+		m_state.looping = looping;
+		if (!is_bound()) { return; }
+		ma_sound_set_looping(m_sound.get(), looping ? MA_TRUE : MA_FALSE);
+	}
+
+	[[nodiscard]] auto get_loop_region() const -> std::optional<LoopRegion> final { return m_state.loop_region; }
+
+	auto set_loop_region(std::optional<LoopRegion> const region) -> bool final {
+		if (region && region->end != 0 && region->end <= region->start) { return false; }
+		m_state.loop_region = region;
+		if (is_bound()) { m_sound->set_loop_region(region); }
+		return true;
+	}
+
+	[[nodiscard]] auto get_gain() const -> float final { return m_state.gain; }
+
+	void set_gain(float const gain) final {
+		m_state.gain = std::clamp(gain, 0.0f, 1.0f);
+		if (!is_bound()) { return; }
+		ma_sound_set_volume(m_sound.get(), m_state.gain);
+	}
+
+	[[nodiscard]] auto get_position() const -> Vec3f final { return m_state.position; }
+
+	void set_position(Vec3f const& pos) final {
+		m_state.position = pos;
+		if (!is_bound()) { return; }
+		ma_sound_set_position(m_sound.get(), pos.x, pos.y, pos.z);
+	}
+
+	[[nodiscard]] auto get_pan() const -> float final { return m_state.pan; }
+
+	void set_pan(float const pan) final {
+		m_state.pan = pan;
+		if (!is_bound()) { return; }
+		ma_sound_set_pan(m_sound.get(), pan);
+	}
+
+	[[nodiscard]] auto get_pitch() const -> float final { return m_state.pitch; }
+
+	void set_pitch(float const pitch) final {
+		m_state.pitch = std::max(pitch, 0.0f);
+		if (!is_bound()) { return; }
+		ma_sound_set_pitch(m_sound.get(), m_state.pitch);
+	}
+
+	[[nodiscard]] auto get_output() const -> IEffect* final { return m_state.output; }
+
+	void set_output(IEffect* effect) final {
+		m_state.output = effect;
+		if (!is_bound()) { return; }
+		attach_output();
+	}
+
+	[[nodiscard]] auto get_analyzer() const -> IAnalyzer* final { return m_state.analyzer; }
+
+	void set_analyzer(IAnalyzer* analyzer) final {
+		m_state.analyzer = analyzer;
+		if (!is_bound()) { return; }
+		attach_output();
+	}
+
+	[[nodiscard]] auto get_mix_group() const -> IMixGroup* final { return m_state.mix_group; }
+
+	void set_mix_group(IMixGroup* group) final {
+		m_state.mix_group = group;
+		if (!is_bound()) { return; }
+		attach_output();
+	}
+
+  private:
+	struct State {
+		Vec3f position{};
+		float gain{1.0f};
+		float pan{0.0f};
+		float pitch{0.0f};
+		bool looping{};
+		std::optional<LoopRegion> loop_region{};
+		IEffect* output{};
+		IAnalyzer* analyzer{};
+		IMixGroup* mix_group{};
+	};
+
+	[[nodiscard]] static constexpr auto to_ms(std::chrono::duration<float> const duration) -> std::uint64_t {
+		return std::uint64_t(std::chrono::duration_cast<std::chrono::milliseconds>(duration).count());
+	}
+
+	template <typename F>
+	[[nodiscard]] auto get_float(F func) const -> std::chrono::duration<float> {
+		auto ret = float{};
+		auto const result = func(m_sound.get(), &ret);
+		if (result != MA_SUCCESS) { return 0s; }
+		return std::chrono::duration<float>{ret};
+	}
+
+	template <typename... Args>
+	auto try_create_sound(Args&&... args) -> bool {
+		if (m_sound && is_playing()) { stop(); }
+		auto sound = std::make_unique<Sound>(m_engine, std::forward<Args>(args)...);
+		if (sound->failed) { return false; }
+
+		m_sound = std::move(sound);
+		m_ref.reset();
+		copy_state_to_ma();
+		set_cursor(0s);
+		static auto const callback = +[](void* self, ma_sound* /*sound*/) { static_cast<Source*>(self)->on_end(); };
+		ma_sound_set_end_callback(m_sound.get(), callback, this);
+		return true;
+	}
+
+	void on_end() {
+		m_ended.store(true);
+		m_ended.notify_one();
+	}
+
+	void copy_state_to_ma() const {
+		assert(is_bound());
+		ma_sound_set_volume(m_sound.get(), m_state.gain);
+		ma_sound_set_looping(m_sound.get(), m_state.looping ? MA_TRUE : MA_FALSE);
+		m_sound->set_loop_region(m_state.loop_region);
+		auto const& pos = m_state.position;
+		ma_sound_set_position(m_sound.get(), pos.x, pos.y, pos.z);
+		ma_sound_set_pan(m_sound.get(), m_state.pan);
+		ma_sound_set_pitch(m_sound.get(), m_state.pitch);
+		attach_output();
+	}
+
+	void attach_output() const {
+		if (m_state.mix_group != nullptr) {
+			ma_node_attach_output_bus(m_sound.get(), 0, detail::get_input_node(*m_state.mix_group), 0);
+			return;
+		}
+		auto* output = detail::get_input_node(m_engine, m_state.output);
+		detail::attach_output(m_sound.get(), m_state.analyzer, output);
+	}
+
+	ma_engine& m_engine;
+	PlaybackTimer const& m_timer;
+	DeviceStarter* m_starter{};
+	std::shared_ptr<void const> m_ref{};
+	std::unique_ptr<Sound> m_sound{};
+	State m_state{};
+	std::atomic_bool m_ended{};
+};
+
+namespace command {
+struct BindBuffer {
+	Buffer const* buffer{};
+};
+struct BindSharedBuffer {
+	std::shared_ptr<Buffer const> buffer{};
+};
+struct BindStream {
+	IStream* stream{};
+};
+struct BindBufferView {
+	BufferView view{};
+};
+struct BindSharedStream {
+	std::shared_ptr<IStream> stream{};
+};
+struct OpenFileStream {
+	std::string path{};
+};
+struct Unbind {};
+struct Play {};
+struct Stop {};
+struct SetCursor {
+	std::chrono::duration<float> position{};
+};
+struct SetSpatialized {
+	bool spatialized{};
+};
+struct SetFadeIn {
+	std::chrono::duration<float> duration{};
+	float gain{};
+};
+struct SetFadeOut {
+	std::chrono::duration<float> duration{};
+};
+struct SetLooping {
+	bool looping{};
+};
+struct SetLoopRegion {
+	std::optional<LoopRegion> region{};
+};
+struct SetGain {
+	float gain{};
+};
+struct SetPosition {
+	Vec3f position{};
+};
+struct SetPan {
+	float pan{};
+};
+struct SetPitch {
+	float pitch{};
+};
+struct SetOutput {
+	IEffect* effect{};
+};
+struct SetAnalyzer {
+	IAnalyzer* analyzer{};
+};
+struct SetMixGroup {
+	IMixGroup* group{};
+};
+
+using Op = std::variant<BindBuffer, BindSharedBuffer, BindBufferView, BindStream, BindSharedStream, OpenFileStream,
+						Unbind, Play, Stop, SetCursor, SetSpatialized, SetFadeIn, SetFadeOut, SetLooping, SetLoopRegion,
+						SetGain, SetPosition, SetPan, SetPitch, SetOutput, SetAnalyzer, SetMixGroup>;
+
+// applies an Op to a Source, on the command thread.
+struct Apply {
+	Source& source;
+
+	void operator()(BindBuffer const& op) const { source.bind_to(op.buffer); }
+	void operator()(BindSharedBuffer& op) const { source.bind_to(std::move(op.buffer)); }
+	void operator()(BindBufferView const& op) const { source.bind_to(op.view); }
+	void operator()(BindStream const& op) const { source.bind_to(op.stream); }
+	void operator()(BindSharedStream& op) const { source.bind_to(std::move(op.stream)); }
+	void operator()(OpenFileStream const& op) const { source.open_file_stream(op.path.c_str()); }
+	void operator()(Unbind /*op*/) const { source.unbind(); }
+	void operator()(Play /*op*/) const { source.play(); }
+	void operator()(Stop /*op*/) const { source.stop(); }
+	void operator()(SetCursor const& op) const { source.set_cursor(op.position); }
+	void operator()(SetSpatialized const& op) const { source.set_spatialized(op.spatialized); }
+	void operator()(SetFadeIn const& op) const { source.set_fade_in(op.duration, op.gain); }
+	void operator()(SetFadeOut const& op) const { source.set_fade_out(op.duration); }
+	void operator()(SetLooping const& op) const { source.set_looping(op.looping); }
+	void operator()(SetLoopRegion const& op) const { source.set_loop_region(op.region); }
+	void operator()(SetGain const& op) const { source.set_gain(op.gain); }
+	void operator()(SetPosition const& op) const { source.set_position(op.position); }
+	void operator()(SetPan const& op) const { source.set_pan(op.pan); }
+	void operator()(SetPitch const& op) const { source.set_pitch(op.pitch); }
+	void operator()(SetOutput const& op) const { source.set_output(op.effect); }
+	void operator()(SetAnalyzer const& op) const { source.set_analyzer(op.analyzer); }
+	void operator()(SetMixGroup const& op) const { source.set_mix_group(op.group); }
+};
+} // namespace command
+
+// state shared between an AsyncSource and the command thread.
+// the Source is only ever touched on the command thread, status is published for other threads to read.
+struct AsyncTarget {
+	struct Status {
+		std::atomic_bool bound{};
+		std::atomic_bool playing{};
+		std::atomic_bool at_end{true};
+		std::atomic_bool spatialized{};
+		std::atomic<float> duration{-1.0f};
+		std::atomic<float> cursor{-1.0f};
+		detail::Snapshot<PlaybackClock> clock{};
+		std::atomic_bool ended{};
+	};
+
+	AsyncTarget(ma_engine& engine, PlaybackTimer const& timer, DeviceStarter* starter)
+		: source(engine, timer, starter) {}
+
+	// called by producers before queueing a Play: optimistically mark as playing,
+	// so that wait_until_ended() can be called right after.
+	void begin_play() {
+		auto lock = std::scoped_lock{status_mutex};
+		pending.fetch_add(1);
+		status.ended.store(false);
+		status.playing.store(true);
+	}
+
+	void publish() {
+		if (pending.load() > 0) { return; }
+		auto const bound = source.is_bound();
+		auto const playing = source.is_playing();
+		auto const at_end = source.at_end();
+		auto const spatialized = source.is_spatialized();
+		auto const duration = source.get_duration();
+		auto const cursor = source.get_cursor();
+		auto const clock = source.get_clock();
+		// don't clobber optimistic status set by producers while their commands are in flight.
+		auto lock = std::scoped_lock{status_mutex};
+		if (pending.load() > 0) { return; }
+		status.bound.store(bound);
+		status.playing.store(playing);
+		status.at_end.store(at_end);
+		status.spatialized.store(spatialized);
+		status.duration.store(duration.count());
+		status.cursor.store(cursor.count());
+		status.clock.store(clock);
+		if (!playing && !status.ended.exchange(true)) { status.ended.notify_all(); }
+	}
+
+	Source source;
+	Status status{};
+	std::atomic<std::uint32_t> pending{};
+	// orders optimistic stores against publishes (never locked on the audio thread).
+	std::mutex status_mutex{};
+	// only accessed on the command thread.
+	bool tracked{};
+};
+
+// owns the command thread: pops commands in order and applies them to their targets.
+// also periodically republishes the status of all live targets.
+class CommandQueue {
+  public:
+	struct Command {
+		std::shared_ptr<AsyncTarget> target{};
+		command::Op op{};
+	};
+
+	CommandQueue(CommandQueue const&) = delete;
+	CommandQueue(CommandQueue&&) = delete;
+	auto operator=(CommandQueue const&) -> CommandQueue& = delete;
+	auto operator=(CommandQueue&&) -> CommandQueue& = delete;
+
+	CommandQueue() : m_thread([this](std::stop_token const& stop) { run(stop); }) {}
+
+	~CommandQueue() {
+		m_thread.request_stop();
+		wake();
+	}
+
+	void push(std::shared_ptr<AsyncTarget> target, command::Op op) {
+		auto command = Command{.target = std::move(target), .op = std::move(op)};
+		// back-pressure: the queue is bounded, wait for the command thread to catch up.
+		while (!m_queue.try_push(std::move(command))) { std::this_thread::yield(); }
+		m_pushed.fetch_add(1);
+		wake();
+	}
+
+	void wait_idle() {
+		auto const target = m_pushed.load();
+		for (auto applied = m_applied.load(); applied < target; applied = m_applied.load()) {
+			m_applied.wait(applied);
+		}
+	}
+
+  private:
+	static constexpr auto capacity_v = 4096uz;
+	static constexpr auto refresh_interval_v = 10ms;
+
+	// a burst of pushes signals once: commands pushed while already signaled are drained along with the others.
+	void wake() {
+		if (m_signaled.exchange(true)) { return; }
+		m_signal.release();
+	}
+
+	void run(std::stop_token const& stop) {
+		while (!stop.stop_requested()) {
+			// the flag is only cleared once its release has been consumed, so the semaphore never exceeds 1.
+			if (m_signal.try_acquire_for(refresh_interval_v)) { m_signaled.store(false); }
+			drain();
+			refresh();
+		}
+		drain();
+	}
+
+	void drain() {
+		auto applied = 0uz;
+		for (auto command = m_queue.try_pop(); command; command = m_queue.try_pop()) {
+			auto& target = *command->target;
+			std::visit(command::Apply{.source = target.source}, command->op);
+			if (target.pending.fetch_sub(1) == 1) { target.pending.notify_all(); }
+			target.publish();
+			track(command->target);
+			++applied;
+		}
+		if (applied == 0) { return; }
+		m_applied.fetch_add(applied);
+		m_applied.notify_all();
+	}
+
+	void track(std::shared_ptr<AsyncTarget> const& target) {
+		if (target->tracked) { return; }
+		target->tracked = true;
+		m_targets.emplace_back(target);
+	}
+
+	void refresh() {
+		std::erase_if(m_targets, [](std::weak_ptr<AsyncTarget> const& t) { return t.expired(); });
+		for (auto const& weak : m_targets) {
+			auto const target = weak.lock();
+			if (target) { target->publish(); }
+		}
+	}
+
+	detail::MpscQueue<Command> m_queue{capacity_v};
+	std::binary_semaphore m_signal{0};
+	std::atomic_bool m_signaled{};
+	std::atomic<std::uint64_t> m_pushed{};
+	std::atomic<std::uint64_t> m_applied{};
+	std::vector<std::weak_ptr<AsyncTarget>> m_targets{};
+	std::jthread m_thread;
+};
+
+class AsyncSource : public ISource, public detail::Pooled<AsyncSource> {
+  public:
+	explicit AsyncSource(CommandQueue& queue, ma_engine& engine, PlaybackTimer const& timer, DeviceStarter* starter)
+		: m_queue(queue), m_target(detail::make_pooled_shared<AsyncTarget>(engine, timer, starter)) {}
+
+	// queued commands may refer to data that the caller destroys next (eg a bound Buffer):
+	// unbind, and wait for all of them to be applied.
+	~AsyncSource() override {
+		push(command::Unbind{});
+		for (auto pending = m_target->pending.load(); pending > 0; pending = m_target->pending.load()) {
+			m_target->pending.wait(pending);
+		}
+	}
+
+	[[nodiscard]] auto is_bound() const -> bool final { return status().bound.load(); }
+
+	auto bind_to(Buffer const* buffer) -> bool final {
+		if (buffer == nullptr || !buffer->is_loaded()) { return false; }
+		return push(command::BindBuffer{.buffer = buffer});
+	}
+
+	auto bind_to(std::shared_ptr<Buffer const> buffer) -> bool final {
+		if (!buffer || !buffer->is_loaded()) { return false; }
+		return push(command::BindSharedBuffer{.buffer = std::move(buffer)});
+	}
+
+	auto bind_to(BufferView const& buffer_view) -> bool final {
+		if (!buffer_view.is_loaded()) { return false; }
+		return push(command::BindBufferView{.view = buffer_view});
+	}
+
+	auto bind_to(IStream* custom_stream) -> bool final {
+		if (!is_valid(custom_stream)) { return false; }
+		return push(command::BindStream{.stream = custom_stream});
+	}
+
+	auto bind_to(std::shared_ptr<IStream> custom_stream) -> bool final {
+		if (!is_valid(custom_stream.get())) { return false; }
+		return push(command::BindSharedStream{.stream = std::move(custom_stream)});
+	}
+
+	auto open_file_stream(char const* path) -> bool final {
+		if (path == nullptr || *path == '\0') { return false; }
+		return push(command::OpenFileStream{.path = path});
+	}
+
+	void unbind() final { push(command::Unbind{}); }
+
+	[[nodiscard]] auto is_playing() const -> bool final { return status().playing.load(); }
+
+	void play() final {
+		m_target->begin_play();
+		m_queue.push(m_target, command::Play{});
+	}
+
+	void stop() final { push(command::Stop{}); }
+
+	[[nodiscard]] auto at_end() const -> bool final { return status().at_end.load(); }
+
+	[[nodiscard]] auto can_wait_until_ended() const -> bool final { return !is_looping() && is_playing(); }
+
+	void wait_until_ended() final {
+		if (!can_wait_until_ended()) { return; }
+		status().ended.wait(false);
+	}
+
+	[[nodiscard]] auto get_duration() const -> std::chrono::duration<float> final {
+		return std::chrono::duration<float>{status().duration.load()};
+	}
+
+	[[nodiscard]] auto get_cursor() const -> std::chrono::duration<float> final {
+		return std::chrono::duration<float>{status().cursor.load()};
+	}
+
+	[[nodiscard]] auto get_clock() const -> PlaybackClock final { return status().clock.load(); }
+
+	auto set_cursor(std::chrono::duration<float> const position) -> bool final {
+		if (position < 0s) { return false; }
+		return push(command::SetCursor{.position = position});
+	}
+
+	[[nodiscard]] auto is_spatialized() const -> bool final { return status().spatialized.load(); }
+
+	auto set_spatialized(bool const spatialized) -> bool final {
+		return push(command::SetSpatialized{.spatialized = spatialized});
+	}
+
+	auto set_fade_in(std::chrono::duration<float> const duration, float const gain) -> bool final {
+		return push(command::SetFadeIn{.duration = duration, .gain = gain});
+	}
+
+	auto set_fade_out(std::chrono::duration<float> const duration) -> bool final {
+		return push(command::SetFadeOut{.duration = duration});
+	}
+
+	[[nodiscard]] auto is_looping() const -> bool final { return m_looping.load(); }
+
+	void set_looping(bool const looping) final {
+		m_looping.store(looping);
+		push(command::SetLooping{.looping = looping});
+	}
+
+	[[nodiscard]] auto get_loop_region() const -> std::optional<LoopRegion> final { return m_loop_region.load(); }
+
+	auto set_loop_region(std::optional<LoopRegion> const region) -> bool final {
+		if (region && region->end != 0 && region->end <= region->start) { return false; }
+		m_loop_region.store(region);
+		return push(command::SetLoopRegion{.region = region});
+	}
+
+	[[nodiscard]] auto get_gain() const -> float final { return m_gain.load(); }
+
+	void set_gain(float const gain) final {
+		m_gain.store(std::clamp(gain, 0.0f, 1.0f));
+		push(command::SetGain{.gain = gain});
+	}
+
+	[[nodiscard]] auto get_position() const -> Vec3f final {
+		return Vec3f{.x = m_position[0].load(), .y = m_position[1].load(), .z = m_position[2].load()};
+	}
 
 	void set_position(Vec3f const& pos) final {
-		m_state.position = pos;
-		if (!is_bound()) { return; }
-		ma_sound_set_position(m_sound.get(), pos.x, pos.y, pos.z);
+		m_position[0].store(pos.x);
+		m_position[1].store(pos.y);
+		m_position[2].store(pos.z);
+		push(command::SetPosition{.position = pos});
 	}
 
-	[[nodiscard]] auto get_pan() const -> float final { return m_state.pan; }
+	[[nodiscard]] auto get_pan() const -> float final { return m_pan.load(); }
 
 	void set_pan(float const pan) final {
-		m_state.pan = pan;
-		if (!is_bound()) { return; }
-		ma_sound_set_pan(m_sound.get(), pan);
+		m_pan.store(pan);
+		push(command::SetPan{.pan = pan});
 	}
 
-	[[nodiscard]] auto get_pitch() const -> float final { return m_state.pitch; }
+	[[nodiscard]] auto get_pitch() const -> float final { return m_pitch.load(); }
 
 	void set_pitch(float const pitch) final {
-		m_state.pitch = std::max(pitch, 0.0f);
-		if (!is_bound()) { return; }
-		ma_sound_set_pitch(m_sound.get(), m_state.pitch);
+		m_pitch.store(std::max(pitch, 0.0f));
+		push(command::SetPitch{.pitch = pitch});
 	}
 
-  private:
-	struct State {
-		Vec3f position{};
-		float gain{1.0f};
-		float pan{0.0f};
-		float pitch{0.0f};
-		bool looping{};
-	};
+	[[nodiscard]] auto get_output() const -> IEffect* final { return m_output.load(); }
 
-	[[nodiscard]] static constexpr auto to_ms(std::chrono::duration<float> const duration) -> std::uint64_t {
-		return std::uint64_t(std::chrono::duration_cast<std::chrono::milliseconds>(duration).count());
+	void set_output(IEffect* effect) final {
+		m_output.store(effect);
+		push(command::SetOutput{.effect = effect});
 	}
 
-	template <typename F>
-	[[nodiscard]] auto get_float(F func) const -> std::chrono::duration<float> {
-		auto ret = float{};
-		auto const result = func(m_sound.get(), &ret);
-		if (result != MA_SUCCESS) { return 0s; }
-		return std::chrono::duration<float>{ret};
+	[[nodiscard]] auto get_analyzer() const -> IAnalyzer* final { return m_analyzer.load(); }
+
+	void set_analyzer(IAnalyzer* analyzer) final {
+		m_analyzer.store(analyzer);
+		push(command::SetAnalyzer{.analyzer = analyzer});
 	}
 
-	template <typename... Args>
-	auto try_create_sound(Args&&... args) -> bool {
-		if (m_sound && is_playing()) { stop(); }
-		auto sound = std::make_unique<Sound>(m_engine, std::forward<Args>(args)...);
-		if (sound->failed) { return false; }
+	[[nodiscard]] auto get_mix_group() const -> IMixGroup* final { return m_mix_group.load(); }
 
-		m_sound = std::move(sound);
-		m_ref.reset();
-		copy_state_to_ma();
-		set_cursor(0s);
-		static auto const callback = +[](void* self, ma_sound* /*sound*/) { static_cast<Source*>(self)->on_end(); };
-		ma_sound_set_end_callback(m_sound.get(), callback, this);
-		return true;
+	void set_mix_group(IMixGroup* group) final {
+		m_mix_group.store(group);
+		push(command::SetMixGroup{.group = group});
 	}
 
-	void on_end() {
-		m_ended.store(true);
-		m_ended.notify_one();
+  private:
+	[[nodiscard]] static auto is_valid(IStream const* stream) -> bool {
+		return stream != nullptr && stream->get_channels() > 0 && stream->get_sample_rate() > 0;
 	}
 
-	void copy_state_to_ma() const {
-		assert(is_bound());
-		ma_sound_set_volume(m_sound.get(), m_state.gain);
-		ma_sound_set_looping(m_sound.get(), m_state.looping ? MA_TRUE : MA_FALSE);
-		auto const& pos = m_state.position;
-		ma_sound_set_position(m_sound.get(), pos.x, pos.y, pos.z);
-		ma_sound_set_pan(m_sound.get(), m_state.pan);
-		ma_sound_set_pitch(m_sound.get(), m_state.pitch);
+	[[nodiscard]] auto status() const -> AsyncTarget::Status& { return m_target->status; }
+
+	auto push(command::Op op) -> bool {
+		m_target->pending.fetch_add(1);
+		m_queue.push(m_target, std::move(op));
+		return true;
 	}
 
-	ma_engine& m_engine;
-	std::shared_ptr<void const> m_ref{};
-	std::unique_ptr<Sound> m_sound{};
-	State m_state{};
-	std::atomic_bool m_ended{};
+	CommandQueue& m_queue;
+	std::shared_ptr<AsyncTarget> m_target{};
+
+	// last requested values, returned by getters without a round trip through the command thread.
+	std::atomic_bool m_looping{};
+	detail::Snapshot<std::optional<LoopRegion>> m_loop_region{};
+	std::atomic<float> m_gain{1.0f};
+	std::array<std::atomic<float>, 3> m_position{};
+	std::atomic<float> m_pan{};
+	std::atomic<float> m_pitch{};
+	std::atomic<IEffect*> m_output{};
+	std::atomic<IAnalyzer*> m_analyzer{};
+	std::atomic<IMixGroup*> m_mix_group{};
 };
 
 class Engine : public IEngine {
@@ -515,16 +2014,360 @@ class Engine : public IEngine {
 
 	Engine() = default;
 
-	auto init() -> bool {
-		auto const result = ma_engine_init(nullptr, &m_engine);
-		return result == MA_SUCCESS;
+	auto init(EngineCreateInfo const& create_info) -> bool {
+		m_created = std::chrono::steady_clock::now();
+		auto timings = StartupTimings{};
+		auto phase_start = m_created;
+		auto const end_phase = [&phase_start] {
+			auto const now = std::chrono::steady_clock::now();
+			return std::chrono::duration<float>{now - std::exchange(phase_start, now)};
+		};
+
+		// own the resource manager so that file streams can use custom decoding backends and file systems.
+		auto rm_config = ma_resource_manager_config_init();
+		rm_config.decodedFormat = ma_format_f32;
+		m_allocator.resource = create_info.memory_resource;
+		rm_config.allocationCallbacks = detail::make_allocation_callbacks(&m_allocator);
+		detail::set_custom_backends(rm_config);
+		if (create_info.file_system) {
+			m_file_system = create_info.file_system;
+			rm_config.pVFS = m_vfs.emplace(*m_file_system).as_ma_vfs();
+		}
+		if (ma_resource_manager_init(&rm_config, &m_resource_manager) != MA_SUCCESS) { return false; }
+		m_resource_manager_ready = true;
+		timings.resource_manager = end_phase();
+
+		auto const lazy = create_info.device_start != DeviceStart::Immediate;
+		auto config = ma_engine_config_init();
+		config.pResourceManager = &m_resource_manager;
+		config.allocationCallbacks = rm_config.allocationCallbacks;
+		config.onProcess = [](void* self, float* frames, ma_uint64 count) {
+			static_cast<Engine*>(self)->on_process(frames, count);
+		};
+		config.pProcessUserData = this;
+		config.noAutoStart = MA_TRUE;
+		if (lazy) {
+			// the format of the device is unknown until it is initialized.
+			config.noDevice = MA_TRUE;
+			config.channels = 2;
+			config.sampleRate = Buffer::sample_rate_v;
+		}
+#if defined(CAPO_TRACE)
+		config.dataCallback = &data_callback;
+#endif
+		if (ma_engine_init(&config, &m_engine) != MA_SUCCESS) { return false; }
+		m_engine_ready = true;
+		m_timer.init();
+		m_voices.emplace(m_engine, create_info.oneshot_voices, create_info.oneshot_steal);
+		m_mix_threads = create_info.mix_threads;
+		timings.engine_init = end_phase();
+
+		if (!lazy) {
+			// an Immediate Engine is only created with a running device.
+			if (ma_engine_start(&m_engine) != MA_SUCCESS) { return false; }
+			timings.device = DeviceState::Started;
+			timings.device_start = end_phase();
+			timings.until_started = std::chrono::duration<float>{phase_start - m_created};
+			// the device can call back from now on: initialize one-shot voices here, ahead of first use, so that
+			// play_oneshot() never initializes them on the caller's (or audio) thread.
+			m_voices->warm_up();
+			timings.voice_warmup = end_phase();
+		}
+		timings.create_engine = std::chrono::duration<float>{phase_start - m_created};
+		// before the starter thread can update them.
+		m_timings.store(timings);
+		if (lazy) {
+			m_starter.emplace([this] { start_device(); });
+			if (create_info.device_start == DeviceStart::Async) { m_starter->request(); }
+		}
+		return true;
 	}
 
-	~Engine() { ma_engine_uninit(&m_engine); }
+	~Engine() {
+		// join the command thread before any Sounds it may be driving are torn down.
+		m_commands_ptr.store(nullptr);
+		m_commands.reset();
+		if (m_starter) { m_starter->join(); }
+		m_voices.reset();
+		if (m_device_ready) { ma_device_uninit(&m_device); }
+		if (m_engine_ready) { ma_engine_uninit(&m_engine); }
+		// after the audio thread has stopped dispatching to it.
+		m_mixer.reset();
+		if (m_resource_manager_ready) { ma_resource_manager_uninit(&m_resource_manager); }
+	}
 
 	[[nodiscard]] auto get_engine() -> ma_engine& { return m_engine; }
 
-	[[nodiscard]] auto create_source() -> std::unique_ptr<ISource> final { return std::make_unique<Source>(m_engine); }
+	[[nodiscard]] auto create_source() -> std::unique_ptr<ISource> final {
+		return std::make_unique<Source>(m_engine, m_timer, get_starter());
+	}
+
+	[[nodiscard]] auto create_async_source() -> std::unique_ptr<ISource> final {
+		std::call_once(m_commands_init, [this] {
+			m_commands = std::make_unique<CommandQueue>();
+			m_commands_ptr.store(m_commands.get(), std::memory_order_release);
+		});
+		return std::make_unique<AsyncSource>(*m_commands, m_engine, m_timer, get_starter());
+	}
+
+	[[nodiscard]] auto create_effect(EffectDesc const& desc) -> std::unique_ptr<IEffect> final {
+		return detail::create_effect(m_engine, desc);
+	}
+
+	[[nodiscard]] auto create_mix_group() -> std::unique_ptr<IMixGroup> final {
+		std::call_once(m_mixer_init, [this] {
+			m_mixer = std::make_unique<detail::MixScheduler>(m_mix_threads);
+			m_mixer_ptr.store(m_mixer.get(), std::memory_order_release);
+		});
+		return detail::create_mix_group(m_engine, *m_mixer);
+	}
+
+	[[nodiscard]] auto create_analyzer(AnalyzerCreateInfo const& create_info) -> std::unique_ptr<IAnalyzer> final {
+		return detail::create_analyzer(m_engine, create_info);
+	}
+
+	void wait_idle() final {
+		if (auto* commands = m_commands_ptr.load(std::memory_order_acquire)) { commands->wait_idle(); }
+	}
+
+	auto play_oneshot(Buffer const& buffer, OneShotParams const& params) -> bool final {
+		if (!m_voices->play(buffer, params)) { return false; }
+		if (m_starter) { m_starter->request(); }
+		return true;
+	}
+
+	[[nodiscard]] auto get_active_oneshots() const -> std::uint32_t final { return m_voices->get_active_count(); }
+
+	void stop_oneshots() final { m_voices->stop_all(); }
+
+	[[nodiscard]] auto get_memory_usage() const -> std::uint64_t final { return m_allocator.allocated.load(); }
+
+	[[nodiscard]] auto get_clock() const -> PlaybackClock final { return m_timer.get_engine_clock(); }
+
+	[[nodiscard]] auto get_startup_timings() const -> StartupTimings final { return m_timings.load(); }
+
+	[[nodiscard]] auto get_analyzer() const -> IAnalyzer* final { return m_analyzer.load(); }
+
+	void set_analyzer(IAnalyzer* analyzer) final {
+		auto const* previous = m_analyzer.exchange(analyzer);
+		if (previous != nullptr && previous != analyzer) { wait_for_callback(); }
+	}
+
+	[[nodiscard]] auto create_output_capture(OutputCaptureCreateInfo const& create_info)
+		-> std::unique_ptr<IOutputCapture> final {
+		auto const channels = std::uint8_t(ma_engine_get_channels(&m_engine));
+		return detail::create_output_capture(ma_engine_get_sample_rate(&m_engine), channels, create_info);
+	}
+
+	[[nodiscard]] auto get_output_capture() const -> IOutputCapture* final { return m_capture.load(); }
+
+	void set_output_capture(IOutputCapture* capture) final {
+		auto const* previous = m_capture.exchange(capture);
+		if (previous != nullptr && previous != capture) { wait_for_callback(); }
+	}
+
+	[[nodiscard]] auto get_position() const -> Vec3f final {
+		return std::bit_cast<Vec3f>(ma_engine_listener_get_position(&m_engine, 0));
+	}
+
+	void set_position(Vec3f const& position) final {
+		ma_engine_listener_set_position(&m_engine, 0, position.x, position.y, position.z);
+	}
+
+	[[nodiscard]] auto get_direction() const -> Vec3f final {
+		return std::bit_cast<Vec3f>(ma_engine_listener_get_direction(&m_engine, 0));
+	}
+
+	void set_direction(Vec3f const& direction) final {
+		ma_engine_listener_set_direction(&m_engine, 0, direction.x, direction.y, direction.z);
+	}
+
+	[[nodiscard]] auto get_world_up() const -> Vec3f final {
+		return std::bit_cast<Vec3f>(ma_engine_listener_get_world_up(&m_engine, 0));
+	}
+
+	void set_world_up(Vec3f const& direction) final {
+		ma_engine_listener_set_world_up(&m_engine, 0, direction.x, direction.y, direction.z);
+	}
+
+  private:
+	// same as miniaudio's own callback (within a span if tracing).
+	static void data_callback(ma_device* device, void* out, void const* /*in*/, ma_uint32 const frame_count) {
+		CAPO_TRACE_SCOPE("audio_callback");
+		ma_engine_read_pcm_frames(static_cast<ma_engine*>(device->pUserData), out, frame_count, nullptr);
+	}
+
+	[[nodiscard]] auto get_starter() -> DeviceStarter* { return m_starter ? &*m_starter : nullptr; }
+
+	// called on the starter thread of a lazily started Engine.
+	void start_device() {
+		auto timings = m_timings.load();
+		auto phase_start = std::chrono::steady_clock::now();
+		auto const end_phase = [&phase_start] {
+			auto const now = std::chrono::steady_clock::now();
+			return std::chrono::duration<float>{now - std::exchange(phase_start, now)};
+		};
+		auto const finish = [&](DeviceState const state) {
+			timings.device = state;
+			timings.until_started = std::chrono::duration<float>{phase_start - m_created};
+			m_timings.store(timings);
+		};
+
+		// mixes in the engine's format, miniaudio converts to the device's native one.
+		auto config = ma_device_config_init(ma_device_type_playback);
+		config.playback.format = ma_format_f32;
+		config.playback.channels = ma_engine_get_channels(&m_engine);
+		config.sampleRate = ma_engine_get_sample_rate(&m_engine);
+		config.dataCallback = &data_callback;
+		config.pUserData = &m_engine;
+		config.noPreSilencedOutputBuffer = MA_TRUE;
+		config.noClip = MA_TRUE;
+		if (ma_device_init(nullptr, &config, &m_device) != MA_SUCCESS) {
+			timings.device_init = end_phase();
+			finish(DeviceState::Failed);
+			return;
+		}
+		m_device_ready = true;
+		m_timer.set_device(m_device);
+		timings.device_init = end_phase();
+
+		auto const result = ma_device_start(&m_device);
+		timings.device_start = end_phase();
+		finish(result == MA_SUCCESS ? DeviceState::Started : DeviceState::Failed);
+		if (result != MA_SUCCESS) { return; }
+
+		// sounds played before the device was up are already playing: warm voices after the device starts.
+		m_voices->warm_up();
+		timings.voice_warmup = end_phase();
+		m_timings.store(timings);
+	}
+
+	// called on the audio thread.
+	void on_process(float const* frames, ma_uint64 const count) {
+		CAPO_TRACE_SCOPE("Engine::on_process");
+		m_timer.on_process(count);
+		// kick off mixing of the next block of each group, while this one plays.
+		if (auto* mixer = m_mixer_ptr.load(std::memory_order_acquire)) { mixer->dispatch(std::uint32_t(count)); }
+		auto const samples = std::span{frames, std::size_t(count) * ma_engine_get_channels(&m_engine)};
+		// odd while the capture / analyzer may be in use (see wait_for_callback()).
+		m_callback_epoch.fetch_add(1);
+		if (auto* capture = m_capture.load()) { detail::capture_output(*capture, samples); }
+		if (auto* analyzer = m_analyzer.load()) { detail::analyze_output(*analyzer, samples); }
+		m_callback_epoch.fetch_add(1);
+	}
+
+	// called after detaching a capture / analyzer: waits until a callback that may still be using it has returned.
+	// all seq_cst: a callback that loaded the previous pointer incremented the epoch before the detaching exchange.
+	void wait_for_callback() const {
+		auto const epoch = m_callback_epoch.load();
+		if (epoch % 2 == 0) { return; }
+		while (m_callback_epoch.load() == epoch) { std::this_thread::yield(); }
+	}
+
+	// must outlive all allocations by the resource manager and engine.
+	detail::AllocatorContext m_allocator{};
+	std::shared_ptr<IFileSystem> m_file_system{};
+	std::optional<detail::Vfs> m_vfs{};
+	ma_resource_manager m_resource_manager{};
+	ma_engine m_engine{};
+	PlaybackTimer m_timer{m_engine};
+	bool m_resource_manager_ready{};
+	bool m_engine_ready{};
+	std::once_flag m_commands_init{};
+	std::unique_ptr<CommandQueue> m_commands{};
+	std::atomic<CommandQueue*> m_commands_ptr{};
+	std::optional<VoicePool> m_voices{};
+	std::atomic<IAnalyzer*> m_analyzer{};
+	std::atomic<IOutputCapture*> m_capture{};
+	std::atomic<std::uint64_t> m_callback_epoch{};
+	std::uint32_t m_mix_threads{};
+	std::once_flag m_mixer_init{};
+	std::unique_ptr<detail::MixScheduler> m_mixer{};
+	std::atomic<detail::MixScheduler*> m_mixer_ptr{};
+
+	// only used if started lazily.
+	ma_device m_device{};
+	bool m_device_ready{};
+	std::optional<DeviceStarter> m_starter{};
+
+	std::chrono::steady_clock::time_point m_created{};
+	detail::Snapshot<StartupTimings> m_timings{};
+};
+
+// an Engine without a device (or any threads): mixes on the thread that calls render().
+class RenderContext : public IRenderContext {
+  public:
+	RenderContext(RenderContext const&) = delete;
+	RenderContext(RenderContext&&) = delete;
+	auto operator=(RenderContext const&) -> RenderContext& = delete;
+	auto operator=(RenderContext&&) -> RenderContext& = delete;
+
+	RenderContext() = default;
+
+	auto init(RenderContextCreateInfo const& create_info) -> bool {
+		if (create_info.sample_rate == 0 || create_info.channels == 0) { return false; }
+		// jobs (stream pages, seeks) are processed inline, in render().
+		auto rm_config = ma_resource_manager_config_init();
+		rm_config.decodedFormat = ma_format_f32;
+		rm_config.flags = MA_RESOURCE_MANAGER_FLAG_NO_THREADING;
+		rm_config.jobThreadCount = 0;
+		rm_config.allocationCallbacks = detail::make_allocation_callbacks(&m_allocator);
+		detail::set_custom_backends(rm_config);
+		if (create_info.file_system) {
+			m_file_system = create_info.file_system;
+			rm_config.pVFS = m_vfs.emplace(*m_file_system).as_ma_vfs();
+		}
+		if (ma_resource_manager_init(&rm_config, &m_resource_manager) != MA_SUCCESS) { return false; }
+		m_resource_manager_ready = true;
+
+		auto config = ma_engine_config_init();
+		config.pResourceManager = &m_resource_manager;
+		config.allocationCallbacks = rm_config.allocationCallbacks;
+		config.noDevice = MA_TRUE;
+		config.channels = create_info.channels;
+		config.sampleRate = create_info.sample_rate;
+		config.onProcess = [](void* self, float* /*frames*/, ma_uint64 count) {
+			static_cast<RenderContext*>(self)->m_timer.on_process(count);
+		};
+		config.pProcessUserData = this;
+		if (ma_engine_init(&config, &m_engine) != MA_SUCCESS) { return false; }
+		m_engine_ready = true;
+		m_timer.init();
+		return true;
+	}
+
+	~RenderContext() {
+		if (m_engine_ready) { ma_engine_uninit(&m_engine); }
+		if (m_resource_manager_ready) { ma_resource_manager_uninit(&m_resource_manager); }
+	}
+
+	[[nodiscard]] auto get_sample_rate() const -> std::uint32_t final { return ma_engine_get_sample_rate(&m_engine); }
+	[[nodiscard]] auto get_channels() const -> std::uint8_t final {
+		return std::uint8_t(ma_engine_get_channels(&m_engine));
+	}
+
+	[[nodiscard]] auto create_source() -> std::unique_ptr<ISource> final {
+		return std::make_unique<Source>(m_engine, m_timer);
+	}
+
+	auto render(std::span<float> out) -> std::uint64_t final {
+		CAPO_TRACE_SCOPE("RenderContext::render");
+		auto const channels = std::size_t(get_channels());
+		// shorter than a stream page, so that no stream runs dry within a block.
+		auto const block_frames = std::size_t(get_sample_rate() / 10);
+		auto ret = std::uint64_t{};
+		while (out.size() >= channels) {
+			process_jobs();
+			auto const frames = std::min(out.size() / channels, block_frames);
+			auto read = ma_uint64{};
+			if (ma_engine_read_pcm_frames(&m_engine, out.data(), frames, &read) != MA_SUCCESS || read == 0) { break; }
+			ret += read;
+			out = out.subspan(std::size_t(read) * channels);
+		}
+		return ret;
+	}
+
+	[[nodiscard]] auto get_clock() const -> PlaybackClock final { return m_timer.get_engine_clock(); }
 
 	[[nodiscard]] auto get_position() const -> Vec3f final {
 		return std::bit_cast<Vec3f>(ma_engine_listener_get_position(&m_engine, 0));
@@ -551,59 +2394,218 @@ class Engine : public IEngine {
 	}
 
   private:
+	void process_jobs() {
+		while (ma_resource_manager_process_next_job(&m_resource_manager) == MA_SUCCESS) {}
+	}
+
+	// must outlive all allocations by the resource manager and engine.
+	detail::AllocatorContext m_allocator{};
+	std::shared_ptr<IFileSystem> m_file_system{};
+	std::optional<detail::Vfs> m_vfs{};
+	ma_resource_manager m_resource_manager{};
 	ma_engine m_engine{};
+	PlaybackTimer m_timer{m_engine};
+	bool m_resource_manager_ready{};
+	bool m_engine_ready{};
 };
 } // namespace
 
-void Buffer::set_frames(std::vector<float> samples, std::uint8_t const channels) {
+BufferView::BufferView(std::shared_ptr<Buffer const> buffer, std::uint64_t const first_frame,
+					   std::uint64_t const frame_count)
+	: m_buffer(std::move(buffer)) {
+	if (!m_buffer) { return; }
+	auto const total = m_buffer->get_frame_count();
+	m_first_frame = std::min(first_frame, total);
+	m_frame_count = std::min(frame_count, total - m_first_frame);
+}
+
+auto BufferView::get_channel_map() const -> std::span<Channel const> {
+	if (!m_buffer) { return {}; }
+	return m_buffer->get_channel_map();
+}
+
+auto BufferView::get_samples() const -> std::span<float const> {
+	if (!m_buffer) { return {}; }
+	auto const channels = std::size_t(m_buffer->get_channels());
+	auto const samples = m_buffer->get_samples();
+	// the Buffer may have shrunk since construction (eg trimmed).
+	auto const offset = std::min(std::size_t(m_first_frame) * channels, samples.size());
+	return samples.subspan(offset, std::min(std::size_t(m_frame_count) * channels, samples.size() - offset));
+}
+
+auto BufferView::get_subview(std::uint64_t const first_frame, std::uint64_t const frame_count) const -> BufferView {
+	auto ret = BufferView{};
+	if (!m_buffer) { return ret; }
+	ret.m_buffer = m_buffer;
+	ret.m_first_frame = m_first_frame + std::min(first_frame, m_frame_count);
+	ret.m_frame_count = std::min(frame_count, m_frame_count - (ret.m_first_frame - m_first_frame));
+	return ret;
+}
+
+auto Buffer::get_channel_map() const -> std::span<Channel const> {
+	if (m_channel_map.size() != m_channels) { return get_default_channel_map(m_channels); }
+	return m_channel_map;
+}
+
+auto Buffer::get_memory_usage() const -> std::uint64_t {
+	return (get_samples().size() * sizeof(float)) + (m_channel_map.size() * sizeof(Channel));
+}
+
+void Buffer::set_frames(std::vector<float> const& samples, std::uint8_t const channels) {
+	set_frames(std::pmr::vector<float>{samples.begin(), samples.end(), m_samples.get_allocator()}, channels);
+}
+
+void Buffer::set_frames(std::vector<float> const& samples, std::span<Channel const> channel_map) {
+	set_frames(std::pmr::vector<float>{samples.begin(), samples.end(), m_samples.get_allocator()}, channel_map);
+}
+
+void Buffer::set_frames(std::vector<float>&& samples, std::uint8_t const channels) {
+	if (!get_memory_resource()->is_equal(*std::pmr::new_delete_resource())) {
+		set_frames(std::as_const(samples), channels);
+		return;
+	}
+	// std::allocator and the new / delete resource share the heap: keep the storage as is.
+	m_samples.clear();
+	m_samples.shrink_to_fit();
+	m_owned_samples = std::move(samples);
+	m_channel_map.clear();
+	m_channels = channels;
+	m_trim = {};
+	m_charge.resize(get_memory_usage());
+}
+
+void Buffer::set_frames(std::vector<float>&& samples, std::span<Channel const> channel_map) {
+	if (!get_memory_resource()->is_equal(*std::pmr::new_delete_resource())) {
+		set_frames(std::as_const(samples), channel_map);
+		return;
+	}
+	m_samples.clear();
+	m_samples.shrink_to_fit();
+	m_owned_samples = std::move(samples);
+	m_channel_map.assign(channel_map.begin(), channel_map.end());
+	m_channels = std::uint8_t(channel_map.size());
+	m_trim = {};
+	m_charge.resize(get_memory_usage());
+}
+
+void Buffer::set_frames(std::pmr::vector<float> samples, std::uint8_t const channels) {
+	// move assignment copies if the memory resources differ.
 	m_samples = std::move(samples);
+	m_owned_samples = {};
+	m_channel_map.clear();
 	m_channels = channels;
+	m_trim = {};
+	m_charge.resize(get_memory_usage());
+}
+
+void Buffer::set_frames(std::pmr::vector<float> samples, std::span<Channel const> channel_map) {
+	m_samples = std::move(samples);
+	m_owned_samples = {};
+	m_channel_map.assign(channel_map.begin(), channel_map.end());
+	m_channels = std::uint8_t(channel_map.size());
+	m_trim = {};
+	m_charge.resize(get_memory_usage());
 }
 
 auto Buffer::decode_bytes(std::span<std::byte const> bytes, std::optional<Encoding> const encoding) -> bool {
-	auto decoder = Decoder{bytes, encoding};
-	return !decoder.failed && decoder.decode(m_samples, m_channels);
+	// decoder allocations are made from the same resource as samples.
+	auto allocator = detail::AllocatorContext{.resource = get_memory_resource()};
+	auto decoder = Decoder{bytes, encoding, allocator};
+	if (decoder.failed) { return false; }
+	// check the budget before decoding, the reserve size is exact unless the decoder cannot report its length.
+	auto charge = MemoryCharge::try_create(MemoryCategory::DecodedPcm, decoder.get_reserve_size() * sizeof(float));
+	if (!charge) { return false; }
+	auto samples = std::pmr::vector<float>{m_samples.get_allocator()};
+	auto channels = std::uint8_t{};
+	auto channel_map = std::vector<Channel>{};
+	if (!decoder.decode(samples, channels, channel_map)) { return false; }
+	m_samples = std::move(samples);
+	m_owned_samples = {};
+	m_channels = channels;
+	m_channel_map = std::move(channel_map);
+	m_trim = {};
+	charge->resize(get_memory_usage());
+	m_charge = std::move(*charge);
+	return true;
+}
+
+auto Buffer::decode_file(char const* path, std::optional<Encoding> const encoding) -> bool {
+	return decode_file(get_native_file_system(), path, encoding);
 }
 
-auto Buffer::decode_file(char const* path, std::optional<Encoding> encoding) -> bool {
+auto Buffer::decode_file(IFileSystem& file_system, char const* path, std::optional<Encoding> encoding) -> bool {
+	CAPO_TRACE_SCOPE("Buffer::decode_file");
 	if (!encoding) { encoding = guess_encoding(path); }
-	auto const bytes = file_to_bytes(path);
+	auto file = file_system.open(path);
+	if (!file) { return false; }
+	if (auto const contents = file->get_contents(); !contents.empty()) { return decode_bytes(contents, encoding); }
+	auto const charge = MemoryCharge::try_create(MemoryCategory::EncodedData, file->get_size());
+	if (!charge) { return false; }
+	auto const bytes = detail::read_all(*file);
 	if (bytes.empty()) { return false; }
 	return decode_bytes(bytes, encoding);
 }
 
+auto Buffer::trim_silence(SilenceTrim const& params) -> std::uint64_t {
+	if (!is_loaded()) { return 0; }
+	auto const threshold = std::max(params.threshold, 0.0f);
+	auto const first = detail::find_first_audible(get_samples(), threshold);
+	if (first == get_samples().size()) { return 0; }
+	auto const last = detail::find_last_audible(get_samples(), threshold);
+
+	auto const frame_count = get_frame_count();
+	auto const padding = std::uint64_t(std::max(params.padding.count(), 0.0f) * float(sample_rate_v));
+	auto const begin = (first / m_channels) - std::min(first / m_channels, padding);
+	auto const end = std::min(((last + m_channels - 1) / m_channels) + padding, frame_count);
+	if (begin == 0 && end == frame_count) { return 0; }
+
+	// copy the audible range into storage of the exact size (rather than erasing in place and shrinking).
+	auto const samples = get_samples().subspan(begin * m_channels, (end - begin) * m_channels);
+	auto trimmed = std::pmr::vector<float>{samples.begin(), samples.end(), m_samples.get_allocator()};
+	m_samples = std::move(trimmed);
+	m_owned_samples = {};
+	m_trim.leading += begin;
+	m_trim.trailing += frame_count - end;
+	m_charge.resize(get_memory_usage());
+	return frame_count - (end - begin);
+}
+
 auto IStreamPipe::read_samples(std::span<float> out) -> std::size_t {
-	auto ret = drain_buffer(out);
-	assert(ret <= out.size());
-	if (ret == out.size()) { return ret; }
-	out = out.subspan(ret);
+	auto const pending = fill_buffer(out.size());
+	auto const size = std::min(out.size(), pending.size());
+	std::ranges::copy(pending.subspan(0, size), out.begin());
+	m_read += size;
+	return size;
+}
+
+auto IStreamPipe::acquire_samples(std::size_t const max_count) -> std::optional<std::span<float const>> {
+	auto const pending = fill_buffer(max_count);
+	return pending.subspan(0, std::min(max_count, pending.size()));
+}
+
+void IStreamPipe::release_samples(std::size_t const count) {
+	m_read += std::min(count, m_buffer.size() - m_read);
+}
+
+auto IStreamPipe::fill_buffer(std::size_t const count) -> std::span<float const> {
+	if (m_read == m_buffer.size()) {
+		m_buffer.clear();
+		m_read = 0;
+	} else if (m_read > 0 && m_buffer.size() - m_read < count) {
+		// consumed samples are only dropped when more need to be pushed, instead of on every read.
+		m_buffer.erase(m_buffer.begin(), m_buffer.begin() + std::ptrdiff_t(m_read));
+		m_read = 0;
+	}
 
-	while (m_buffer.size() < out.size()) {
+	while (m_buffer.size() - m_read < count) {
 		auto const prev_size = m_buffer.size();
 		push_samples(m_buffer);
 		auto const at_end = m_buffer.size() == prev_size;
 		if (at_end) { break; }
 	}
 
-	ret += drain_buffer(out);
-	return ret;
-}
-
-auto IStreamPipe::drain_buffer(std::span<float> out) -> std::size_t {
-	if (m_buffer.empty()) { return 0; }
-	auto const size = std::min(out.size(), m_buffer.size());
-	auto const src = std::span{m_buffer}.subspan(0, size);
-	auto const remain = std::span{m_buffer}.subspan(size);
-	std::ranges::copy(src, out.begin());
-	if (remain.empty()) {
-		m_buffer.clear();
-	} else {
-		m_staging.clear();
-		std::ranges::copy(remain, std::back_inserter(m_staging));
-		m_buffer.clear();
-		std::ranges::copy(m_staging, std::back_inserter(m_buffer));
-	}
-	return size;
+	m_charge.resize(m_buffer.capacity() * sizeof(float));
+	return std::span{m_buffer}.subspan(m_read);
 }
 } // namespace capo
 
@@ -612,23 +2614,50 @@ auto capo::guess_encoding(std::string_view const path) -> std::optional<Encoding
 }
 
 auto capo::file_to_bytes(char const* path) -> std::vector<std::byte> {
-	auto file = std::ifstream{path, std::ios::binary | std::ios::ate};
-	if (!file) { return {}; }
-	auto const size = file.tellg();
-	file.seekg(std::ios::beg, {});
-	auto ret = std::vector<std::byte>{};
-	ret.resize(std::size_t(size));
-	void* data = ret.data();
-	file.read(static_cast<char*>(data), size);
-	return ret;
+	return file_to_bytes(get_native_file_system(), path);
 }
 
-auto capo::create_engine() -> std::unique_ptr<IEngine> {
+auto capo::create_engine(EngineCreateInfo const& create_info) -> std::unique_ptr<IEngine> {
 	auto ret = std::make_unique<Engine>();
-	if (!ret->init()) { return {}; }
+	if (!ret->init(create_info)) { return {}; }
+	return ret;
+}
+
+auto capo::create_render_context(RenderContextCreateInfo const& create_info) -> std::unique_ptr<IRenderContext> {
+	auto ret = std::make_unique<RenderContext>();
+	if (!ret->init(create_info)) { return {}; }
+	return ret;
+}
+
+void capo::render_batch(std::span<RenderJob const> jobs, std::uint32_t const thread_count) {
+	detail::parallel_for(jobs.size(), thread_count, [jobs](std::size_t const index) {
+		auto const& job = jobs[index];
+		if (job.context != nullptr) { job.context->render(job.output); }
+	});
+}
+
+auto capo::create_progressive_buffer(std::vector<std::byte> bytes, ProgressiveBufferCreateInfo const& create_info)
+	-> std::shared_ptr<IProgressiveBuffer> {
+	if (bytes.empty()) { return {}; }
+	auto ret = std::make_shared<ProgressiveBuffer>(std::move(bytes), create_info.encoding);
+	if (ret->has_failed()) { return {}; }
+	auto const preroll = std::max(create_info.preroll.count(), 0.0f) * float(Buffer::sample_rate_v);
+	ret->wait_for_frames(std::uint64_t(preroll));
 	return ret;
 }
 
+auto capo::create_progressive_buffer(char const* path, ProgressiveBufferCreateInfo const& create_info)
+	-> std::shared_ptr<IProgressiveBuffer> {
+	return create_progressive_buffer(get_native_file_system(), path, create_info);
+}
+
+auto capo::create_progressive_buffer(IFileSystem& file_system, char const* path,
+									 ProgressiveBufferCreateInfo create_info) -> std::shared_ptr<IProgressiveBuffer> {
+	if (path == nullptr || *path == '\0') { return {}; }
+	if (!create_info.encoding) { create_info.encoding = guess_encoding(path); }
+	return create_progressive_buffer(file_to_bytes(file_system, path), create_info);
+}
+
 void capo::format_duration_to(std::string& out, std::chrono::duration<float> const dt) {
 	if (dt < 1h) {
 		std::format_to(std::back_inserter(out), "{:%M:%S}", dt);
@@ -0,0 +1,233 @@
+#include "channel_mixer.hpp"
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <optional>
+
+namespace capo {
+namespace detail {
+namespace {
+// -3dB.
+constexpr auto half_power_v = 0.70710678f;
+
+struct Target {
+	Channel channel{Channel::None};
+	float weight{};
+};
+
+// targets for an input channel when folding it into an output map (unused targets are None).
+struct Fold {
+	Target first{};
+	Target second{};
+
+	[[nodiscard]] constexpr auto get_targets() const -> std::array<Target, 2> { return {first, second}; }
+};
+
+auto get_folds(Channel const in) -> std::span<Fold const> {
+	using enum Channel;
+	static constexpr auto h = half_power_v;
+	switch (in) {
+	case Mono: {
+		static constexpr auto ret = std::array{Fold{{Mono, 1.0f}}, Fold{{FrontLeft, 1.0f}, {FrontRight, 1.0f}}};
+		return ret;
+	}
+	case FrontLeft: {
+		static constexpr auto ret = std::array{Fold{{FrontLeft, 1.0f}}};
+		return ret;
+	}
+	case FrontRight: {
+		static constexpr auto ret = std::array{Fold{{FrontRight, 1.0f}}};
+		return ret;
+	}
+	case FrontCenter: {
+		static constexpr auto ret = std::array{Fold{{FrontCenter, 1.0f}}, Fold{{FrontLeft, h}, {FrontRight, h}}};
+		return ret;
+	}
+	case Lfe: {
+		static constexpr auto ret = std::array{Fold{{Lfe, 1.0f}}};
+		return ret;
+	}
+	case BackLeft: {
+		static constexpr auto ret =
+			std::array{Fold{{BackLeft, 1.0f}}, Fold{{SideLeft, 1.0f}}, Fold{{FrontLeft, h}}};
+		return ret;
+	}
+	case BackRight: {
+		static constexpr auto ret =
+			std::array{Fold{{BackRight, 1.0f}}, Fold{{SideRight, 1.0f}}, Fold{{FrontRight, h}}};
+		return ret;
+	}
+	case FrontLeftCenter: {
+		static constexpr auto ret = std::array{Fold{{FrontLeftCenter, 1.0f}}, Fold{{FrontLeft, h}, {FrontCenter, h}},
+											   Fold{{FrontLeft, 1.0f}}};
+		return ret;
+	}
+	case FrontRightCenter: {
+		static constexpr auto ret = std::array{Fold{{FrontRightCenter, 1.0f}},
+											   Fold{{FrontRight, h}, {FrontCenter, h}}, Fold{{FrontRight, 1.0f}}};
+		return ret;
+	}
+	case BackCenter: {
+		static constexpr auto ret =
+			std::array{Fold{{BackCenter, 1.0f}}, Fold{{BackLeft, h}, {BackRight, h}},
+					   Fold{{SideLeft, h}, {SideRight, h}}, Fold{{FrontLeft, h}, {FrontRight, h}}};
+		return ret;
+	}
+	case SideLeft: {
+		static constexpr auto ret =
+			std::array{Fold{{SideLeft, 1.0f}}, Fold{{BackLeft, 1.0f}}, Fold{{FrontLeft, h}}};
+		return ret;
+	}
+	case SideRight: {
+		static constexpr auto ret =
+			std::array{Fold{{SideRight, 1.0f}}, Fold{{BackRight, 1.0f}}, Fold{{FrontRight, h}}};
+		return ret;
+	}
+	default: return {};
+	}
+}
+
+auto find_channel(std::span<Channel const> map, Channel const channel) -> std::optional<std::size_t> {
+	auto const it = std::ranges::find(map, channel);
+	if (it == map.end()) { return {}; }
+	return std::size_t(it - map.begin());
+}
+
+// weights are row-major: [out_channel][in_channel].
+auto build_weights(std::span<Channel const> in_map, std::span<Channel const> out_map) -> std::vector<float> {
+	auto ret = std::vector<float>(in_map.size() * out_map.size());
+	for (auto in = 0uz; in < in_map.size(); ++in) {
+		for (auto const& fold : get_folds(in_map[in])) {
+			auto const targets = fold.get_targets();
+			auto const fits = std::ranges::all_of(targets, [out_map](Target const& target) {
+				return target.channel == Channel::None || find_channel(out_map, target.channel);
+			});
+			if (!fits) { continue; }
+			for (auto const& target : targets) {
+				if (target.channel == Channel::None) { continue; }
+				ret[*find_channel(out_map, target.channel) * in_map.size() + in] += target.weight;
+			}
+			break;
+		}
+	}
+	return ret;
+}
+
+auto build_mono_weights(std::span<Channel const> in_map) -> std::vector<float> {
+	// fold to stereo first, then average both sides.
+	static constexpr auto stereo_v = std::array{Channel::FrontLeft, Channel::FrontRight};
+	auto const stereo = build_weights(in_map, stereo_v);
+	auto ret = std::vector<float>(in_map.size());
+	for (auto in = 0uz; in < in_map.size(); ++in) { ret[in] = 0.5f * (stereo[in] + stereo[in_map.size() + in]); }
+	return ret;
+}
+
+// channel counts are compile time constants: the loops get fully unrolled and the
+// per-frame dot products vectorized.
+template <std::size_t In, std::size_t Out>
+void mix_fixed(float const* in, float* out, std::size_t const frames, float const* weights,
+			   [[maybe_unused]] std::size_t const in_channels, [[maybe_unused]] std::size_t const out_channels) {
+	assert(in_channels == In && out_channels == Out);
+	auto w = std::array<float, In * Out>{};
+	std::copy_n(weights, w.size(), w.begin());
+	for (auto frame = 0uz; frame < frames; ++frame, in += In, out += Out) {
+		for (auto o = 0uz; o < Out; ++o) {
+			auto accumulator = 0.0f;
+			for (auto i = 0uz; i < In; ++i) { accumulator += w[o * In + i] * in[i]; }
+			out[o] = accumulator;
+		}
+	}
+}
+
+void mix_dynamic(float const* in, float* out, std::size_t const frames, float const* weights,
+				 std::size_t const in_channels, std::size_t const out_channels) {
+	for (auto frame = 0uz; frame < frames; ++frame, in += in_channels, out += out_channels) {
+		for (auto o = 0uz; o < out_channels; ++o) {
+			auto const* row = weights + (o * in_channels);
+			auto accumulator = 0.0f;
+			for (auto i = 0uz; i < in_channels; ++i) { accumulator += row[i] * in[i]; }
+			out[o] = accumulator;
+		}
+	}
+}
+
+template <std::size_t In, std::size_t Out>
+struct FixedKernel {
+	std::size_t in_channels{In};
+	std::size_t out_channels{Out};
+	decltype(&mix_dynamic) kernel{&mix_fixed<In, Out>};
+};
+
+struct KernelEntry {
+	std::size_t in_channels{};
+	std::size_t out_channels{};
+	decltype(&mix_dynamic) kernel{};
+
+	template <std::size_t In, std::size_t Out>
+	constexpr KernelEntry(FixedKernel<In, Out> const fixed)
+		: in_channels(fixed.in_channels), out_channels(fixed.out_channels), kernel(fixed.kernel) {}
+};
+
+auto select_kernel(std::size_t const in_channels, std::size_t const out_channels) {
+	// downmixes to mono / stereo, 5.1 <-> 7.1, and remaps within a layout.
+	static constexpr auto kernels_v = std::array{
+		KernelEntry{FixedKernel<2, 2>{}}, KernelEntry{FixedKernel<3, 2>{}}, KernelEntry{FixedKernel<4, 2>{}},
+		KernelEntry{FixedKernel<5, 2>{}}, KernelEntry{FixedKernel<6, 2>{}}, KernelEntry{FixedKernel<7, 2>{}},
+		KernelEntry{FixedKernel<8, 2>{}}, KernelEntry{FixedKernel<6, 1>{}}, KernelEntry{FixedKernel<8, 1>{}},
+		KernelEntry{FixedKernel<6, 6>{}}, KernelEntry{FixedKernel<8, 6>{}}, KernelEntry{FixedKernel<6, 8>{}},
+		KernelEntry{FixedKernel<8, 8>{}},
+	};
+	for (auto const& entry : kernels_v) {
+		if (entry.in_channels == in_channels && entry.out_channels == out_channels) { return entry.kernel; }
+	}
+	return &mix_dynamic;
+}
+} // namespace
+
+ChannelMixer::ChannelMixer(std::span<Channel const> in_map, std::span<Channel const> out_map)
+	: m_in_channels(in_map.size()), m_out_channels(out_map.size()),
+	  m_kernel(select_kernel(in_map.size(), out_map.size())) {
+	if (out_map.size() == 1 && out_map.front() == Channel::Mono) {
+		m_weights = build_mono_weights(in_map);
+	} else {
+		m_weights = build_weights(in_map, out_map);
+	}
+}
+
+void ChannelMixer::mix(std::span<float const> in, std::span<float> out) const {
+	if (m_in_channels == 0 || m_out_channels == 0) { return; }
+	auto const frames = in.size() / m_in_channels;
+	assert(out.size() >= frames * m_out_channels);
+	m_kernel(in.data(), out.data(), frames, m_weights.data(), m_in_channels, m_out_channels);
+}
+
+auto ChannelMixer::is_required(std::span<Channel const> in_map, std::span<Channel const> out_map) -> bool {
+	return !std::ranges::equal(in_map, out_map);
+}
+} // namespace detail
+
+auto get_default_channel_map(std::uint8_t const channels) -> std::span<Channel const> {
+	using enum Channel;
+	static constexpr auto mono_v = std::array{Mono};
+	static constexpr auto stereo_v = std::array{FrontLeft, FrontRight};
+	static constexpr auto surround_30_v = std::array{FrontLeft, FrontRight, FrontCenter};
+	static constexpr auto surround_40_v = std::array{FrontLeft, FrontRight, FrontCenter, BackCenter};
+	static constexpr auto surround_50_v = std::array{FrontLeft, FrontRight, FrontCenter, BackLeft, BackRight};
+	static constexpr auto surround_51_v = std::array{FrontLeft, FrontRight, FrontCenter, Lfe, SideLeft, SideRight};
+	static constexpr auto surround_61_v =
+		std::array{FrontLeft, FrontRight, FrontCenter, Lfe, BackCenter, SideLeft, SideRight};
+	static constexpr auto surround_71_v =
+		std::array{FrontLeft, FrontRight, FrontCenter, Lfe, BackLeft, BackRight, SideLeft, SideRight};
+	switch (channels) {
+	case 1: return mono_v;
+	case 2: return stereo_v;
+	case 3: return surround_30_v;
+	case 4: return surround_40_v;
+	case 5: return surround_50_v;
+	case 6: return surround_51_v;
+	case 7: return surround_61_v;
+	case 8: return surround_71_v;
+	default: return {};
+	}
+}
+} // namespace capo
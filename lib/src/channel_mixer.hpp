@@ -0,0 +1,36 @@
+#pragma once
+#include <capo/channel_layout.hpp>
+#include <cstddef>
+#include <span>
+#include <vector>
+
+namespace capo::detail {
+/// \brief Converts interleaved PCM between channel maps via a precomputed mixing matrix.
+/// Missing speaker positions are folded down as per ITU-R BS.775 (LFE is dropped).
+/// Common layout pairs use fixed size kernels that the compiler can fully unroll and vectorize.
+class ChannelMixer {
+  public:
+	explicit ChannelMixer(std::span<Channel const> in_map, std::span<Channel const> out_map);
+
+	[[nodiscard]] auto get_in_channels() const -> std::size_t { return m_in_channels; }
+	[[nodiscard]] auto get_out_channels() const -> std::size_t { return m_out_channels; }
+
+	/// \brief Mix whole frames of input into output.
+	/// \param in Interleaved input samples.
+	/// \param out Interleaved output samples, must hold as many frames as in.
+	void mix(std::span<float const> in, std::span<float> out) const;
+
+	/// \brief Check whether a mixer is required to route a channel map to another.
+	[[nodiscard]] static auto is_required(std::span<Channel const> in_map, std::span<Channel const> out_map) -> bool;
+
+  private:
+	// weights are stored row-major: [out_channel][in_channel].
+	using Kernel = void (*)(float const* in, float* out, std::size_t frames, float const* weights,
+							std::size_t in_channels, std::size_t out_channels);
+
+	std::vector<float> m_weights{};
+	std::size_t m_in_channels{};
+	std::size_t m_out_channels{};
+	Kernel m_kernel{};
+};
+} // namespace capo::detail
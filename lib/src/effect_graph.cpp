@@ -0,0 +1,190 @@
+#include <miniaudio.h>
+#include <ma_reverb_node.h>
+#include <algorithm>
+#include <variant>
+#include "effect_graph.hpp"
+
+namespace capo {
+namespace {
+[[nodiscard]] constexpr auto to_order(std::uint8_t const order) -> ma_uint32 {
+	return std::clamp(ma_uint32(order), ma_uint32(1), ma_uint32(MA_MAX_FILTER_ORDER));
+}
+
+void set_reverb_params(verblib& reverb, effect::Reverb const& desc) {
+	verblib_set_room_size(&reverb, desc.room_size);
+	verblib_set_damping(&reverb, desc.damping);
+	verblib_set_width(&reverb, desc.width);
+	verblib_set_wet(&reverb, desc.wet);
+	verblib_set_dry(&reverb, desc.dry);
+}
+
+// wraps one of miniaudio's effect nodes, attached to an engine's node graph.
+// inputs attach to the node's only input bus, where the graph mixes them before processing.
+class Effect : public IEffect {
+  public:
+	Effect(Effect const&) = delete;
+	Effect(Effect&&) = delete;
+	auto operator=(Effect const&) -> Effect& = delete;
+	auto operator=(Effect&&) -> Effect& = delete;
+
+	explicit Effect(ma_engine& engine) : m_engine(engine) {}
+
+	~Effect() { std::visit([this](auto& node) { uninit(node); }, m_node); }
+
+	auto init(EffectDesc const& desc) -> bool {
+		if (!std::visit([this](auto const& d) { return init(d); }, desc)) {
+			m_node = std::monostate{};
+			return false;
+		}
+		m_desc = desc;
+		// nodes are initialized detached.
+		return set_output(nullptr);
+	}
+
+	[[nodiscard]] auto get_node() -> ma_node* {
+		return std::visit([](auto& node) { return to_node(node); }, m_node);
+	}
+
+	[[nodiscard]] auto get_desc() const -> EffectDesc const& final { return m_desc; }
+
+	auto set_desc(EffectDesc const& desc) -> bool final {
+		auto const visitor = [this](auto& node, auto const& d) { return apply(node, d); };
+		if (!std::visit(visitor, m_node, desc)) { return false; }
+		m_desc = desc;
+		return true;
+	}
+
+	[[nodiscard]] auto get_gain() const -> float final { return ma_node_get_output_bus_volume(get_node(), 0); }
+
+	void set_gain(float const gain) final { ma_node_set_output_bus_volume(get_node(), 0, std::max(gain, 0.0f)); }
+
+	[[nodiscard]] auto get_output() const -> IEffect* final { return m_output; }
+
+	auto set_output(IEffect* effect) -> bool final {
+		for (auto const* it = effect; it != nullptr; it = it->get_output()) {
+			if (it == this) { return false; }
+		}
+		auto* output = detail::get_input_node(m_engine, effect);
+		if (ma_node_attach_output_bus(get_node(), 0, output, 0) != MA_SUCCESS) { return false; }
+		m_output = effect;
+		return true;
+	}
+
+  private:
+	using Node = std::variant<std::monostate, ma_lpf_node, ma_hpf_node, ma_biquad_node, ma_delay_node, ma_reverb_node>;
+
+	[[nodiscard]] auto get_node() const -> ma_node* { return const_cast<Effect*>(this)->get_node(); }
+
+	[[nodiscard]] auto get_channels() const -> ma_uint32 { return ma_engine_get_channels(&m_engine); }
+	[[nodiscard]] auto get_sample_rate() const -> ma_uint32 { return ma_engine_get_sample_rate(&m_engine); }
+	[[nodiscard]] auto get_graph() const -> ma_node_graph* { return ma_engine_get_node_graph(&m_engine); }
+	// nodes are allocated like the engine's own sounds, so that they are tracked with it.
+	[[nodiscard]] auto get_callbacks() const -> ma_allocation_callbacks const* {
+		return &m_engine.allocationCallbacks;
+	}
+
+	auto init(effect::LowPass const& desc) -> bool {
+		auto const config =
+			ma_lpf_node_config_init(get_channels(), get_sample_rate(), desc.cutoff, to_order(desc.order));
+		auto& node = m_node.emplace<ma_lpf_node>();
+		return ma_lpf_node_init(get_graph(), &config, get_callbacks(), &node) == MA_SUCCESS;
+	}
+
+	auto init(effect::HighPass const& desc) -> bool {
+		auto const config =
+			ma_hpf_node_config_init(get_channels(), get_sample_rate(), desc.cutoff, to_order(desc.order));
+		auto& node = m_node.emplace<ma_hpf_node>();
+		return ma_hpf_node_init(get_graph(), &config, get_callbacks(), &node) == MA_SUCCESS;
+	}
+
+	auto init(effect::Biquad const& desc) -> bool {
+		auto const config =
+			ma_biquad_node_config_init(get_channels(), desc.b0, desc.b1, desc.b2, desc.a0, desc.a1, desc.a2);
+		auto& node = m_node.emplace<ma_biquad_node>();
+		return ma_biquad_node_init(get_graph(), &config, get_callbacks(), &node) == MA_SUCCESS;
+	}
+
+	auto init(effect::Delay const& desc) -> bool {
+		auto const frames = ma_uint32(std::max(desc.delay.count(), 0.0f) * float(get_sample_rate()));
+		if (frames == 0) { return false; }
+		auto const config = ma_delay_node_config_init(get_channels(), get_sample_rate(), frames, desc.decay);
+		auto& node = m_node.emplace<ma_delay_node>();
+		if (ma_delay_node_init(get_graph(), &config, get_callbacks(), &node) != MA_SUCCESS) { return false; }
+		ma_delay_node_set_wet(&node, desc.wet);
+		ma_delay_node_set_dry(&node, desc.dry);
+		return true;
+	}
+
+	auto init(effect::Reverb const& desc) -> bool {
+		// verblib only supports mono and stereo.
+		auto const config = ma_reverb_node_config_init(get_channels(), get_sample_rate());
+		auto& node = m_node.emplace<ma_reverb_node>();
+		if (ma_reverb_node_init(get_graph(), &config, get_callbacks(), &node) != MA_SUCCESS) { return false; }
+		// ma_reverb_node_init() ignores the parameters in config.
+		set_reverb_params(node.reverb, desc);
+		return true;
+	}
+
+	auto apply(ma_lpf_node& node, effect::LowPass const& desc) const -> bool {
+		auto const config =
+			ma_lpf_config_init(ma_format_f32, get_channels(), get_sample_rate(), desc.cutoff, to_order(desc.order));
+		return ma_lpf_node_reinit(&config, &node) == MA_SUCCESS;
+	}
+
+	auto apply(ma_hpf_node& node, effect::HighPass const& desc) const -> bool {
+		auto const config =
+			ma_hpf_config_init(ma_format_f32, get_channels(), get_sample_rate(), desc.cutoff, to_order(desc.order));
+		return ma_hpf_node_reinit(&config, &node) == MA_SUCCESS;
+	}
+
+	auto apply(ma_biquad_node& node, effect::Biquad const& desc) const -> bool {
+		auto const config =
+			ma_biquad_config_init(ma_format_f32, get_channels(), desc.b0, desc.b1, desc.b2, desc.a0, desc.a1, desc.a2);
+		return ma_biquad_node_reinit(&config, &node) == MA_SUCCESS;
+	}
+
+	auto apply(ma_delay_node& node, effect::Delay const& desc) const -> bool {
+		if (desc.delay != std::get<effect::Delay>(m_desc).delay) { return false; }
+		ma_delay_node_set_decay(&node, desc.decay);
+		ma_delay_node_set_wet(&node, desc.wet);
+		ma_delay_node_set_dry(&node, desc.dry);
+		return true;
+	}
+
+	static auto apply(ma_reverb_node& node, effect::Reverb const& desc) -> bool {
+		set_reverb_params(node.reverb, desc);
+		return true;
+	}
+
+	// mismatched types.
+	static auto apply(auto& /*node*/, auto const& /*desc*/) -> bool { return false; }
+
+	void uninit(std::monostate /*node*/) const {}
+	void uninit(ma_lpf_node& node) const { ma_lpf_node_uninit(&node, get_callbacks()); }
+	void uninit(ma_hpf_node& node) const { ma_hpf_node_uninit(&node, get_callbacks()); }
+	void uninit(ma_biquad_node& node) const { ma_biquad_node_uninit(&node, get_callbacks()); }
+	void uninit(ma_delay_node& node) const { ma_delay_node_uninit(&node, get_callbacks()); }
+	void uninit(ma_reverb_node& node) const { ma_reverb_node_uninit(&node, get_callbacks()); }
+
+	static auto to_node(std::monostate /*node*/) -> ma_node* { return nullptr; }
+	static auto to_node(auto& node) -> ma_node* { return &node; }
+
+	ma_engine& m_engine;
+	Node m_node{};
+	EffectDesc m_desc{};
+	IEffect* m_output{};
+};
+} // namespace
+
+auto detail::create_effect(ma_engine& engine, EffectDesc const& desc) -> std::unique_ptr<IEffect> {
+	auto ret = std::make_unique<Effect>(engine);
+	if (!ret->init(desc)) { return {}; }
+	return ret;
+}
+
+auto detail::get_input_node(ma_engine& engine, IEffect* effect) -> ma_node* {
+	if (effect == nullptr) { return ma_engine_get_endpoint(&engine); }
+	// all Effects are created by create_effect().
+	return static_cast<Effect*>(effect)->get_node();
+}
+} // namespace capo
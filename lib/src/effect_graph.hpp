@@ -0,0 +1,14 @@
+#pragma once
+#include <miniaudio.h>
+#include <capo/effect.hpp>
+#include <memory>
+
+namespace capo::detail {
+/// \brief Create an Effect node in an engine's node graph, initially outputting to its endpoint.
+/// \returns null on failure.
+[[nodiscard]] auto create_effect(ma_engine& engine, EffectDesc const& desc) -> std::unique_ptr<IEffect>;
+
+/// \brief Obtain the node that inputs to an Effect attach to.
+/// \param effect Effect created by create_effect(), null for the engine endpoint.
+[[nodiscard]] auto get_input_node(ma_engine& engine, IEffect* effect) -> ma_node*;
+} // namespace capo::detail
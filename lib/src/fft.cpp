@@ -0,0 +1,132 @@
+#include "fft.hpp"
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cassert>
+#include <cmath>
+#include <numbers>
+
+namespace capo::detail {
+namespace {
+// butterflies are computed in batches of independent lanes, which the compiler maps to SIMD registers.
+constexpr auto lanes_v = 8uz;
+using Lanes = std::array<float, lanes_v>;
+
+void butterfly(float* a_re, float* a_im, float* b_re, float* b_im, float const* w_re, float const* w_im) {
+	auto ar = Lanes{};
+	auto ai = Lanes{};
+	auto br = Lanes{};
+	auto bi = Lanes{};
+	auto wr = Lanes{};
+	auto wi = Lanes{};
+	std::copy_n(a_re, lanes_v, ar.begin());
+	std::copy_n(a_im, lanes_v, ai.begin());
+	std::copy_n(b_re, lanes_v, br.begin());
+	std::copy_n(b_im, lanes_v, bi.begin());
+	std::copy_n(w_re, lanes_v, wr.begin());
+	std::copy_n(w_im, lanes_v, wi.begin());
+	for (auto j = 0uz; j < lanes_v; ++j) {
+		auto const t_re = (br[j] * wr[j]) - (bi[j] * wi[j]);
+		auto const t_im = (br[j] * wi[j]) + (bi[j] * wr[j]);
+		br[j] = ar[j] - t_re;
+		bi[j] = ai[j] - t_im;
+		ar[j] += t_re;
+		ai[j] += t_im;
+	}
+	std::ranges::copy(ar, a_re);
+	std::ranges::copy(ai, a_im);
+	std::ranges::copy(br, b_re);
+	std::ranges::copy(bi, b_im);
+}
+} // namespace
+
+RealFft::RealFft(std::size_t const size) : m_size(size) {
+	assert(size >= 4 && std::has_single_bit(size));
+	auto const half_size = size / 2;
+	auto const bits = std::size_t(std::bit_width(half_size)) - 1;
+	m_bit_reverse.resize(half_size);
+	for (auto i = 0uz; i < half_size; ++i) {
+		auto reversed = 0uz;
+		for (auto bit = 0uz; bit < bits; ++bit) { reversed |= ((i >> bit) & 1) << (bits - 1 - bit); }
+		m_bit_reverse.at(i) = reversed;
+	}
+
+	static constexpr auto tau_v = 2.0 * std::numbers::pi;
+	m_stage_re.resize(half_size - 1);
+	m_stage_im.resize(half_size - 1);
+	for (auto length = 2uz; length <= half_size; length *= 2) {
+		auto const half = length / 2;
+		for (auto j = 0uz; j < half; ++j) {
+			auto const angle = -tau_v * double(j) / double(length);
+			m_stage_re.at(half - 1 + j) = float(std::cos(angle));
+			m_stage_im.at(half - 1 + j) = float(std::sin(angle));
+		}
+	}
+
+	m_split_cos.resize(half_size);
+	m_split_sin.resize(half_size);
+	for (auto k = 0uz; k < half_size; ++k) {
+		auto const angle = tau_v * double(k) / double(size);
+		m_split_cos.at(k) = float(std::cos(angle));
+		m_split_sin.at(k) = float(std::sin(angle));
+	}
+
+	m_re.resize(half_size);
+	m_im.resize(half_size);
+}
+
+void RealFft::compute_magnitudes(std::span<float const> in, std::span<float> out) {
+	assert(in.size() == m_size && out.size() == get_bin_count());
+	auto const half_size = m_size / 2;
+	// pack even / odd samples as real / imaginary parts, in bit reversed order.
+	for (auto k = 0uz; k < half_size; ++k) {
+		auto const index = m_bit_reverse[k];
+		m_re[index] = in[2 * k];
+		m_im[index] = in[(2 * k) + 1];
+	}
+
+	transform();
+
+	out[0] = std::abs(m_re[0] + m_im[0]);
+	out[half_size] = std::abs(m_re[0] - m_im[0]);
+	for (auto k = 1uz; k < half_size; ++k) {
+		// separate the spectra of even and odd samples, and combine them.
+		auto const even_re = 0.5f * (m_re[k] + m_re[half_size - k]);
+		auto const even_im = 0.5f * (m_im[k] - m_im[half_size - k]);
+		auto const odd_re = 0.5f * (m_re[k] - m_re[half_size - k]);
+		auto const odd_im = 0.5f * (m_im[k] + m_im[half_size - k]);
+		auto const cos = m_split_cos[k];
+		auto const sin = m_split_sin[k];
+		auto const re = even_re + (cos * odd_im) - (sin * odd_re);
+		auto const im = even_im - (sin * odd_im) - (cos * odd_re);
+		out[k] = std::sqrt((re * re) + (im * im));
+	}
+}
+
+void RealFft::transform() {
+	auto const half_size = m_size / 2;
+	auto* re = m_re.data();
+	auto* im = m_im.data();
+	for (auto length = 2uz; length <= half_size; length *= 2) {
+		auto const half = length / 2;
+		auto const* w_re = m_stage_re.data() + half - 1;
+		auto const* w_im = m_stage_im.data() + half - 1;
+		for (auto i = 0uz; i < half_size; i += length) {
+			auto j = 0uz;
+			for (; j + lanes_v <= half; j += lanes_v) {
+				butterfly(re + i + j, im + i + j, re + i + j + half, im + i + j + half, w_re + j, w_im + j);
+			}
+			for (; j < half; ++j) {
+				auto const a = i + j;
+				auto const b = a + half;
+				auto const t_re = (re[b] * w_re[j]) - (im[b] * w_im[j]);
+				auto const t_im = (re[b] * w_im[j]) + (im[b] * w_re[j]);
+				re[b] = re[a] - t_re;
+				im[b] = im[a] - t_im;
+				re[a] += t_re;
+				im[a] += t_im;
+			}
+		}
+	}
+}
+} // namespace capo::detail
@@ -0,0 +1,37 @@
+#pragma once
+#include <cstddef>
+#include <span>
+#include <vector>
+
+namespace capo::detail {
+/// \brief Radix-2 FFT of real input, computed via a half size complex FFT.
+/// Data is kept as separate real / imaginary arrays with contiguous per-stage twiddle tables,
+/// butterflies are computed in batches that the compiler vectorizes (no intrinsics required).
+class RealFft {
+  public:
+	/// \param size Number of real input samples, must be a power of 2 (at least 4).
+	explicit RealFft(std::size_t size);
+
+	[[nodiscard]] auto get_size() const -> std::size_t { return m_size; }
+	[[nodiscard]] auto get_bin_count() const -> std::size_t { return (m_size / 2) + 1; }
+
+	/// \brief Compute the magnitude of each bin.
+	/// \param in Real input, size must equal get_size().
+	/// \param out Magnitudes, size must equal get_bin_count().
+	void compute_magnitudes(std::span<float const> in, std::span<float> out);
+
+  private:
+	void transform();
+
+	std::size_t m_size{};
+	std::vector<std::size_t> m_bit_reverse{};
+	// twiddles of each stage of the half size FFT, stage of length L at offset L/2 - 1.
+	std::vector<float> m_stage_re{};
+	std::vector<float> m_stage_im{};
+	// twiddles to split the half size FFT into the real FFT.
+	std::vector<float> m_split_cos{};
+	std::vector<float> m_split_sin{};
+	std::vector<float> m_re{};
+	std::vector<float> m_im{};
+};
+} // namespace capo::detail
@@ -0,0 +1,132 @@
+#include <capo/file_system.hpp>
+#include <fstream>
+#include "trace.hpp"
+#include "vfs.hpp"
+
+namespace capo {
+namespace {
+class NativeFile : public IFile {
+  public:
+	explicit NativeFile(char const* path) : m_file(path, std::ios::binary | std::ios::ate) {
+		if (!m_file) { return; }
+		m_size = std::uint64_t(m_file.tellg());
+		m_file.seekg(0, std::ios::beg);
+	}
+
+	[[nodiscard]] auto is_open() const -> bool { return m_file.is_open(); }
+
+	[[nodiscard]] auto read(std::span<std::byte> out) -> std::size_t final {
+		void* data = out.data();
+		m_file.read(static_cast<char*>(data), std::streamsize(out.size()));
+		auto const ret = std::size_t(m_file.gcount());
+		// clear eof so that subsequent seeks work.
+		if (m_file.eof()) { m_file.clear(); }
+		return ret;
+	}
+
+	[[nodiscard]] auto seek(std::int64_t const offset, SeekOrigin const origin) -> bool final {
+		auto const dir = [origin] {
+			switch (origin) {
+			case SeekOrigin::Current: return std::ios::cur;
+			case SeekOrigin::End: return std::ios::end;
+			default: return std::ios::beg;
+			}
+		}();
+		m_file.seekg(offset, dir);
+		return m_file.good();
+	}
+
+	[[nodiscard]] auto tell() const -> std::uint64_t final {
+		auto const ret = m_file.tellg();
+		return ret < 0 ? 0 : std::uint64_t(ret);
+	}
+
+	[[nodiscard]] auto get_size() const -> std::uint64_t final { return m_size; }
+
+  private:
+	// tellg() is non-const.
+	mutable std::ifstream m_file;
+	std::uint64_t m_size{};
+};
+
+class NativeFileSystem : public IFileSystem {
+  public:
+	[[nodiscard]] auto open(char const* path) -> std::unique_ptr<IFile> final {
+		auto ret = std::make_unique<NativeFile>(path);
+		if (!ret->is_open()) { return {}; }
+		return ret;
+	}
+};
+
+constexpr auto to_seek_origin(ma_seek_origin const origin) -> SeekOrigin {
+	switch (origin) {
+	case ma_seek_origin_current: return SeekOrigin::Current;
+	case ma_seek_origin_end: return SeekOrigin::End;
+	default: return SeekOrigin::Begin;
+	}
+}
+
+auto to_file(ma_vfs_file file) -> IFile& { return *static_cast<IFile*>(file); }
+} // namespace
+
+namespace detail {
+auto read_all(IFile& file) -> std::vector<std::byte> {
+	CAPO_TRACE_SCOPE("read_all");
+	auto ret = std::vector<std::byte>(std::size_t(file.get_size()));
+	auto size = 0uz;
+	while (size < ret.size()) {
+		auto const read = file.read(std::span{ret}.subspan(size));
+		if (read == 0) { break; }
+		size += read;
+	}
+	ret.resize(size);
+	return ret;
+}
+
+Vfs::Vfs(IFileSystem& file_system) : ma_vfs_callbacks({}), m_file_system(&file_system) {
+	onOpen = [](ma_vfs* vfs, char const* path, ma_uint32 mode, ma_vfs_file* out) -> ma_result {
+		if ((mode & MA_OPEN_MODE_WRITE) != 0) { return MA_NOT_IMPLEMENTED; }
+		auto file = static_cast<Vfs*>(static_cast<ma_vfs_callbacks*>(vfs))->get_file_system().open(path);
+		if (!file) { return MA_DOES_NOT_EXIST; }
+		*out = file.release();
+		return MA_SUCCESS;
+	};
+	onClose = [](ma_vfs* /*vfs*/, ma_vfs_file file) -> ma_result {
+		// reclaim ownership released in onOpen.
+		auto const reclaim = std::unique_ptr<IFile>{static_cast<IFile*>(file)};
+		return MA_SUCCESS;
+	};
+	onRead = [](ma_vfs* /*vfs*/, ma_vfs_file file, void* out, std::size_t size, std::size_t* read) -> ma_result {
+		auto& self = to_file(file);
+		*read = self.read(std::span{static_cast<std::byte*>(out), size});
+		if (*read == 0 && size > 0) { return self.has_failed() ? MA_IO_ERROR : MA_AT_END; }
+		return MA_SUCCESS;
+	};
+	onSeek = [](ma_vfs* /*vfs*/, ma_vfs_file file, ma_int64 offset, ma_seek_origin origin) -> ma_result {
+		return to_file(file).seek(offset, to_seek_origin(origin)) ? MA_SUCCESS : MA_ERROR;
+	};
+	onTell = [](ma_vfs* /*vfs*/, ma_vfs_file file, ma_int64* cursor) -> ma_result {
+		*cursor = ma_int64(to_file(file).tell());
+		return MA_SUCCESS;
+	};
+	onInfo = [](ma_vfs* /*vfs*/, ma_vfs_file file, ma_file_info* info) -> ma_result {
+		info->sizeInBytes = to_file(file).get_size();
+		return MA_SUCCESS;
+	};
+}
+} // namespace detail
+} // namespace capo
+
+auto capo::get_native_file_system() -> IFileSystem& {
+	static auto ret = NativeFileSystem{};
+	return ret;
+}
+
+auto capo::file_to_bytes(IFileSystem& file_system, char const* path) -> std::vector<std::byte> {
+	CAPO_TRACE_SCOPE("file_to_bytes");
+	auto file = file_system.open(path);
+	if (!file) { return {}; }
+	auto const contents = file->get_contents();
+	if (!contents.empty()) { return {contents.begin(), contents.end()}; }
+	return detail::read_all(*file);
+}
@@ -0,0 +1,406 @@
+#include <miniaudio.h>
+#include <capo/loudness.hpp>
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cmath>
+#include <limits>
+#include <numbers>
+#include <numeric>
+#include "ma_allocator.hpp"
+#include "ma_channel.hpp"
+#include "ma_encoding.hpp"
+#include "parallel.hpp"
+
+namespace capo {
+namespace {
+constexpr auto neg_inf_v = -std::numeric_limits<float>::infinity();
+
+// BS.1770: loudness = -0.691 + 10 * log10(weighted mean square).
+constexpr auto loudness_offset_v = -0.691;
+// 100ms sub-blocks: momentary blocks are 4 of these (75% overlap), short-term blocks are 30.
+constexpr auto subblocks_per_second_v = 10u;
+constexpr auto momentary_subblocks_v = 4uz;
+constexpr auto short_term_subblocks_v = 30uz;
+constexpr auto absolute_gate_v = -70.0;
+constexpr auto integrated_relative_gate_v = -10.0;
+constexpr auto range_relative_gate_v = -20.0;
+
+[[nodiscard]] auto to_loudness(double const energy) -> double {
+	if (energy <= 0.0) { return -std::numeric_limits<double>::infinity(); }
+	return loudness_offset_v + 10.0 * std::log10(energy);
+}
+
+[[nodiscard]] auto to_energy(double const loudness) -> double {
+	return std::pow(10.0, (loudness - loudness_offset_v) / 10.0);
+}
+
+[[nodiscard]] auto to_db(float const amplitude) -> float {
+	if (amplitude <= 0.0f) { return neg_inf_v; }
+	return 20.0f * std::log10(amplitude);
+}
+
+// transposed direct form II.
+struct Biquad {
+	[[nodiscard]] auto process(double const x) -> double {
+		auto const y = b0 * x + z1;
+		z1 = b1 * x - a1 * y + z2;
+		z2 = b2 * x - a2 * y;
+		return y;
+	}
+
+	double b0{1.0};
+	double b1{};
+	double b2{};
+	double a1{};
+	double a2{};
+	double z1{};
+	double z2{};
+};
+
+// K-weighting (BS.1770-4 Annex 1), re-derived for arbitrary sample rates.
+struct KWeighting {
+	explicit KWeighting(double const sample_rate) {
+		{
+			// stage 1: high shelf (head effects).
+			static constexpr auto f0_v = 1681.974450955533;
+			static constexpr auto gain_v = 3.999843853973347;
+			static constexpr auto q_v = 0.7071752369554196;
+			auto const k = std::tan(std::numbers::pi * f0_v / sample_rate);
+			auto const vh = std::pow(10.0, gain_v / 20.0);
+			auto const vb = std::pow(vh, 0.4996667741545416);
+			auto const a0 = 1.0 + k / q_v + k * k;
+			shelf.b0 = (vh + vb * k / q_v + k * k) / a0;
+			shelf.b1 = 2.0 * (k * k - vh) / a0;
+			shelf.b2 = (vh - vb * k / q_v + k * k) / a0;
+			shelf.a1 = 2.0 * (k * k - 1.0) / a0;
+			shelf.a2 = (1.0 - k / q_v + k * k) / a0;
+		}
+		{
+			// stage 2: high pass (RLB).
+			static constexpr auto f0_v = 38.13547087602444;
+			static constexpr auto q_v = 0.5003270373238773;
+			auto const k = std::tan(std::numbers::pi * f0_v / sample_rate);
+			auto const a0 = 1.0 + k / q_v + k * k;
+			high_pass.b0 = 1.0;
+			high_pass.b1 = -2.0;
+			high_pass.b2 = 1.0;
+			high_pass.a1 = 2.0 * (k * k - 1.0) / a0;
+			high_pass.a2 = (1.0 - k / q_v + k * k) / a0;
+		}
+	}
+
+	[[nodiscard]] auto process(double const x) -> double { return high_pass.process(shelf.process(x)); }
+
+	Biquad shelf{};
+	Biquad high_pass{};
+};
+
+// polyphase windowed-sinc interpolator for true peak detection (BS.1770-4 Annex 2).
+class TruePeak {
+  public:
+	static constexpr auto taps_per_phase_v = 12uz;
+
+	explicit TruePeak(std::uint32_t const sample_rate) {
+		// 4x for 48kHz, 2x for 96kHz, none above.
+		m_factor = sample_rate < 96000 ? 4 : (sample_rate < 192000 ? 2 : 1);
+		auto const taps = taps_per_phase_v * m_factor;
+		auto const centre = double(taps - 1) / 2.0;
+		m_coefficients.resize(taps);
+		for (auto phase = 0uz; phase < m_factor; ++phase) {
+			auto const out = std::span{m_coefficients}.subspan(phase * taps_per_phase_v, taps_per_phase_v);
+			for (auto j = 0uz; j < taps_per_phase_v; ++j) {
+				// window is ordered oldest to newest: tap k applies to x[n - k].
+				auto const k = taps_per_phase_v - 1 - j;
+				auto const n = double(k * m_factor + phase);
+				auto const t = (n - centre) / double(m_factor);
+				auto const sinc = t == 0.0 ? 1.0 : std::sin(std::numbers::pi * t) / (std::numbers::pi * t);
+				auto const hann = 0.5 - 0.5 * std::cos(2.0 * std::numbers::pi * (n + 0.5) / double(taps));
+				out[j] = float(sinc * hann);
+			}
+		}
+	}
+
+	void process(float const x) {
+		m_peak = std::max(m_peak, std::abs(x));
+		if (m_factor == 1) { return; }
+
+		// doubled history: the latest taps_per_phase_v samples are always contiguous.
+		m_position = (m_position + 1) % taps_per_phase_v;
+		m_history[m_position] = m_history[m_position + taps_per_phase_v] = x;
+		auto const window = std::span{m_history}.subspan(m_position + 1, taps_per_phase_v);
+		for (auto phase = 0uz; phase < m_factor; ++phase) {
+			auto const coefficients = std::span{m_coefficients}.subspan(phase * taps_per_phase_v, taps_per_phase_v);
+			auto const y = std::inner_product(window.begin(), window.end(), coefficients.begin(), 0.0f);
+			m_peak = std::max(m_peak, std::abs(y));
+		}
+	}
+
+	[[nodiscard]] auto get_peak() const -> float { return m_peak; }
+
+  private:
+	std::vector<float> m_coefficients{};
+	std::array<float, 2 * taps_per_phase_v> m_history{};
+	std::size_t m_position{};
+	std::size_t m_factor{};
+	float m_peak{};
+};
+
+// BS.1770: LFE is excluded, surrounds are weighted +1.5dB.
+constexpr auto get_weight(Channel const channel) -> double {
+	switch (channel) {
+	case Channel::Lfe: return 0.0;
+	case Channel::BackLeft:
+	case Channel::BackRight:
+	case Channel::SideLeft:
+	case Channel::SideRight: return 1.41;
+	default: return 1.0;
+	}
+}
+
+struct ChannelState {
+	explicit ChannelState(std::uint32_t const sample_rate, double const weight)
+		: filter(double(sample_rate)), true_peak(sample_rate), weight(weight) {}
+
+	KWeighting filter;
+	TruePeak true_peak;
+	double weight{};
+	double sum_squares{};
+	float sample_peak{};
+};
+
+class LoudnessMeter : public ILoudnessMeter {
+  public:
+	// channels without a position in channel_map are weighted 1.0.
+	explicit LoudnessMeter(std::uint8_t const channels, std::span<Channel const> channel_map,
+						   std::uint32_t const sample_rate)
+		: m_sample_rate(sample_rate), m_subblock_frames(std::max(sample_rate / subblocks_per_second_v, 1u)) {
+		m_channels.reserve(channels);
+		for (auto i = 0uz; i < channels; ++i) {
+			auto const weight = i < channel_map.size() ? get_weight(channel_map[i]) : 1.0;
+			m_channels.emplace_back(sample_rate, weight);
+		}
+	}
+
+	[[nodiscard]] auto get_channels() const -> std::uint8_t final { return std::uint8_t(m_channels.size()); }
+	[[nodiscard]] auto get_sample_rate() const -> std::uint32_t final { return m_sample_rate; }
+
+	void push_samples(std::span<float const> samples) final {
+		auto const channel_count = m_channels.size();
+		assert(samples.size() % channel_count == 0);
+		auto frames = samples.size() / channel_count;
+		while (frames > 0) {
+			// process channel-major up to the next sub-block boundary, keeping filter state hot.
+			auto const count = std::min(frames, std::size_t(m_subblock_frames - m_subblock_position));
+			for (auto c = 0uz; c < channel_count; ++c) {
+				auto& channel = m_channels[c];
+				auto sum_squares = 0.0;
+				for (auto frame = 0uz; frame < count; ++frame) {
+					auto const x = samples[frame * channel_count + c];
+					channel.sample_peak = std::max(channel.sample_peak, std::abs(x));
+					channel.true_peak.process(x);
+					auto const y = channel.filter.process(double(x));
+					sum_squares += y * y;
+				}
+				channel.sum_squares += sum_squares;
+			}
+			samples = samples.subspan(count * channel_count);
+			frames -= count;
+			m_subblock_position += std::uint32_t(count);
+			if (m_subblock_position == m_subblock_frames) { finish_subblock(); }
+		}
+	}
+
+	[[nodiscard]] auto get_loudness() const -> Loudness final {
+		auto ret = Loudness{
+			.integrated = neg_inf_v,
+			.range = neg_inf_v,
+			.true_peak = neg_inf_v,
+			.sample_peak = neg_inf_v,
+		};
+		auto sample_peak = 0.0f;
+		auto true_peak = 0.0f;
+		for (auto const& channel : m_channels) {
+			sample_peak = std::max(sample_peak, channel.sample_peak);
+			true_peak = std::max({true_peak, channel.true_peak.get_peak(), channel.sample_peak});
+		}
+		ret.sample_peak = to_db(sample_peak);
+		ret.true_peak = to_db(true_peak);
+		ret.integrated = float(compute_integrated());
+		ret.range = float(compute_range());
+		return ret;
+	}
+
+  private:
+	void finish_subblock() {
+		auto energy = 0.0;
+		for (auto& channel : m_channels) {
+			energy += channel.weight * channel.sum_squares / double(m_subblock_frames);
+			channel.sum_squares = 0.0;
+		}
+		m_subblock_position = 0;
+
+		m_recent[m_recent_index] = energy;
+		m_recent_index = (m_recent_index + 1) % short_term_subblocks_v;
+		m_recent_count = std::min(m_recent_count + 1, short_term_subblocks_v);
+
+		if (m_recent_count >= momentary_subblocks_v) { m_momentary.push_back(get_recent_mean(momentary_subblocks_v)); }
+		if (m_recent_count >= short_term_subblocks_v) {
+			m_short_term.push_back(get_recent_mean(short_term_subblocks_v));
+		}
+	}
+
+	[[nodiscard]] auto get_recent_mean(std::size_t const count) const -> double {
+		auto sum = 0.0;
+		for (auto i = 1uz; i <= count; ++i) {
+			sum += m_recent.at((m_recent_index + short_term_subblocks_v - i) % short_term_subblocks_v);
+		}
+		return sum / double(count);
+	}
+
+	[[nodiscard]] static auto gated_mean(std::span<double const> energies, double const gate) -> double {
+		auto sum = 0.0;
+		auto count = 0uz;
+		for (auto const energy : energies) {
+			if (energy <= gate) { continue; }
+			sum += energy;
+			++count;
+		}
+		return count == 0 ? 0.0 : sum / double(count);
+	}
+
+	[[nodiscard]] auto compute_integrated() const -> double {
+		auto const absolute_gate = to_energy(absolute_gate_v);
+		auto const mean = gated_mean(m_momentary, absolute_gate);
+		if (mean <= 0.0) { return -std::numeric_limits<double>::infinity(); }
+		auto const relative_gate = to_energy(to_loudness(mean) + integrated_relative_gate_v);
+		return to_loudness(gated_mean(m_momentary, std::max(absolute_gate, relative_gate)));
+	}
+
+	[[nodiscard]] auto compute_range() const -> double {
+		// EBU Tech 3342.
+		auto const absolute_gate = to_energy(absolute_gate_v);
+		auto const mean = gated_mean(m_short_term, absolute_gate);
+		if (mean <= 0.0) { return -std::numeric_limits<double>::infinity(); }
+		auto const gate = std::max(absolute_gate, to_energy(to_loudness(mean) + range_relative_gate_v));
+		auto values = std::vector<double>{};
+		values.reserve(m_short_term.size());
+		for (auto const energy : m_short_term) {
+			if (energy > gate) { values.push_back(to_loudness(energy)); }
+		}
+		if (values.empty()) { return 0.0; }
+		std::ranges::sort(values);
+		auto const percentile = [&values](double const p) {
+			auto const index = std::size_t(std::round(p * double(values.size() - 1)));
+			return values.at(index);
+		};
+		return percentile(0.95) - percentile(0.1);
+	}
+
+	std::uint32_t m_sample_rate{};
+	std::uint32_t m_subblock_frames{};
+	std::uint32_t m_subblock_position{};
+	std::vector<ChannelState> m_channels{};
+
+	// ring of the most recent sub-block energies.
+	std::array<double, short_term_subblocks_v> m_recent{};
+	std::size_t m_recent_index{};
+	std::size_t m_recent_count{};
+
+	std::vector<double> m_momentary{};
+	std::vector<double> m_short_term{};
+};
+
+class FileDecoder : public ma_decoder {
+  public:
+	FileDecoder(FileDecoder const&) = delete;
+	FileDecoder(FileDecoder&&) = delete;
+	auto operator=(FileDecoder const&) -> FileDecoder& = delete;
+	auto operator=(FileDecoder&&) -> FileDecoder& = delete;
+
+	explicit FileDecoder(char const* path, std::optional<Encoding> const encoding) : ma_decoder({}) {
+		// decode at native sample rate: K-weighting adapts, and no resampling is required.
+		auto config = ma_decoder_config_init(ma_format_f32, 0, 0);
+		config.encodingFormat = detail::to_ma_encoding(encoding);
+		config.allocationCallbacks = detail::make_allocation_callbacks();
+		detail::set_custom_backends(config);
+		if (ma_decoder_init_file(path, &config, this) != MA_SUCCESS) {
+			failed = true;
+			return;
+		}
+		auto ma_channel_map = std::array<ma_channel, MA_MAX_CHANNELS>{};
+		if (ma_decoder_get_data_format(this, nullptr, &channels, &sample_rate, ma_channel_map.data(),
+									   ma_channel_map.size()) != MA_SUCCESS) {
+			ma_decoder_uninit(this);
+			failed = true;
+			return;
+		}
+		channel_map = detail::to_channel_map(std::span{ma_channel_map}.subspan(0, channels));
+	}
+
+	~FileDecoder() {
+		if (failed) { return; }
+		ma_decoder_uninit(this);
+	}
+
+	ma_uint32 channels{};
+	ma_uint32 sample_rate{};
+	std::vector<Channel> channel_map{};
+	bool failed{};
+};
+} // namespace
+} // namespace capo
+
+auto capo::create_loudness_meter(std::uint8_t const channels, std::uint32_t const sample_rate)
+	-> std::unique_ptr<ILoudnessMeter> {
+	if (channels == 0 || sample_rate == 0) { return {}; }
+	return std::make_unique<LoudnessMeter>(channels, get_default_channel_map(channels), sample_rate);
+}
+
+auto capo::create_loudness_meter(std::span<Channel const> channel_map, std::uint32_t const sample_rate)
+	-> std::unique_ptr<ILoudnessMeter> {
+	if (channel_map.empty() || channel_map.size() > MA_MAX_CHANNELS || sample_rate == 0) { return {}; }
+	return std::make_unique<LoudnessMeter>(std::uint8_t(channel_map.size()), channel_map, sample_rate);
+}
+
+auto capo::measure_loudness(Buffer const& buffer) -> std::optional<Loudness> {
+	if (!buffer.is_loaded()) { return {}; }
+	auto meter = LoudnessMeter{buffer.get_channels(), buffer.get_channel_map(), Buffer::sample_rate_v};
+	meter.push_samples(buffer.get_samples());
+	return meter.get_loudness();
+}
+
+auto capo::measure_loudness_file(char const* path, std::optional<Encoding> encoding) -> std::optional<Loudness> {
+	if (path == nullptr || *path == '\0') { return {}; }
+	if (!encoding) { encoding = guess_encoding(path); }
+	auto decoder = FileDecoder{path, encoding};
+	if (decoder.failed || decoder.channels == 0 || decoder.sample_rate == 0) { return {}; }
+
+	auto meter = LoudnessMeter{std::uint8_t(decoder.channels), decoder.channel_map, decoder.sample_rate};
+	static constexpr auto buffer_size_v = 64uz /*KiB*/ * 1024uz /*B*/ / sizeof(float);
+	auto buffer = std::vector<float>(buffer_size_v);
+	auto const frames_to_read = ma_uint64(buffer.size() / decoder.channels);
+	while (true) {
+		auto frames_read = ma_uint64{};
+		auto const result = ma_decoder_read_pcm_frames(&decoder, buffer.data(), frames_to_read, &frames_read);
+		if (frames_read > 0) { meter.push_samples(std::span{buffer}.subspan(0, frames_read * decoder.channels)); }
+		if (result != MA_SUCCESS || frames_read < frames_to_read) { break; }
+	}
+	return meter.get_loudness();
+}
+
+auto capo::measure_loudness_files(std::span<char const* const> paths, std::uint32_t const thread_count)
+	-> std::vector<std::optional<Loudness>> {
+	auto ret = std::vector<std::optional<Loudness>>(paths.size());
+	auto const measure = [&](std::size_t const i) { ret[i] = measure_loudness_file(paths[i]); };
+	detail::parallel_for(paths.size(), thread_count, measure);
+	return ret;
+}
+
+auto capo::get_normalization_gain(Loudness const& loudness, float const target_lufs, float const true_peak_ceiling)
+	-> float {
+	if (!std::isfinite(loudness.integrated)) { return 1.0f; }
+	auto gain_db = target_lufs - loudness.integrated;
+	if (std::isfinite(loudness.true_peak)) { gain_db = std::min(gain_db, true_peak_ceiling - loudness.true_peak); }
+	return std::pow(10.0f, gain_db / 20.0f);
+}
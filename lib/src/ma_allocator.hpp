@@ -0,0 +1,20 @@
+#pragma once
+#include <miniaudio.h>
+#include <atomic>
+#include <cstdint>
+#include <memory_resource>
+
+namespace capo::detail {
+/// \brief State shared by allocation callbacks.
+/// Must outlive all allocations made via the callbacks.
+struct AllocatorContext {
+	/// \brief Memory resource to allocate from, malloc if null.
+	std::pmr::memory_resource* resource{};
+	/// \brief Bytes currently allocated via the callbacks.
+	std::atomic<std::uint64_t> allocated{};
+};
+
+/// \brief Allocation callbacks that charge MemoryCategory::Miniaudio.
+/// \param context Memory resource and per-owner tracking, optional.
+[[nodiscard]] auto make_allocation_callbacks(AllocatorContext* context = nullptr) -> ma_allocation_callbacks;
+} // namespace capo::detail
@@ -0,0 +1,55 @@
+#pragma once
+#include <miniaudio.h>
+#include <capo/channel_layout.hpp>
+#include <span>
+#include <vector>
+
+namespace capo::detail {
+constexpr auto to_ma_channel(Channel const channel) -> ma_channel {
+	switch (channel) {
+	case Channel::Mono: return MA_CHANNEL_MONO;
+	case Channel::FrontLeft: return MA_CHANNEL_FRONT_LEFT;
+	case Channel::FrontRight: return MA_CHANNEL_FRONT_RIGHT;
+	case Channel::FrontCenter: return MA_CHANNEL_FRONT_CENTER;
+	case Channel::Lfe: return MA_CHANNEL_LFE;
+	case Channel::BackLeft: return MA_CHANNEL_BACK_LEFT;
+	case Channel::BackRight: return MA_CHANNEL_BACK_RIGHT;
+	case Channel::FrontLeftCenter: return MA_CHANNEL_FRONT_LEFT_CENTER;
+	case Channel::FrontRightCenter: return MA_CHANNEL_FRONT_RIGHT_CENTER;
+	case Channel::BackCenter: return MA_CHANNEL_BACK_CENTER;
+	case Channel::SideLeft: return MA_CHANNEL_SIDE_LEFT;
+	case Channel::SideRight: return MA_CHANNEL_SIDE_RIGHT;
+	default: return MA_CHANNEL_NONE;
+	}
+}
+
+/// \brief Positions not representable by Channel (top, aux) map to None.
+constexpr auto to_channel(ma_channel const channel) -> Channel {
+	switch (channel) {
+	case MA_CHANNEL_MONO: return Channel::Mono;
+	case MA_CHANNEL_FRONT_LEFT: return Channel::FrontLeft;
+	case MA_CHANNEL_FRONT_RIGHT: return Channel::FrontRight;
+	case MA_CHANNEL_FRONT_CENTER: return Channel::FrontCenter;
+	case MA_CHANNEL_LFE: return Channel::Lfe;
+	case MA_CHANNEL_BACK_LEFT: return Channel::BackLeft;
+	case MA_CHANNEL_BACK_RIGHT: return Channel::BackRight;
+	case MA_CHANNEL_FRONT_LEFT_CENTER: return Channel::FrontLeftCenter;
+	case MA_CHANNEL_FRONT_RIGHT_CENTER: return Channel::FrontRightCenter;
+	case MA_CHANNEL_BACK_CENTER: return Channel::BackCenter;
+	case MA_CHANNEL_SIDE_LEFT: return Channel::SideLeft;
+	case MA_CHANNEL_SIDE_RIGHT: return Channel::SideRight;
+	default: return Channel::None;
+	}
+}
+
+inline void to_ma_channel_map(std::span<ma_channel> out, std::span<Channel const> channel_map) {
+	for (auto i = 0uz; i < out.size() && i < channel_map.size(); ++i) { out[i] = to_ma_channel(channel_map[i]); }
+}
+
+[[nodiscard]] inline auto to_channel_map(std::span<ma_channel const> channel_map) -> std::vector<Channel> {
+	auto ret = std::vector<Channel>{};
+	ret.reserve(channel_map.size());
+	for (auto const channel : channel_map) { ret.push_back(to_channel(channel)); }
+	return ret;
+}
+} // namespace capo::detail
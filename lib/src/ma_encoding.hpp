@@ -0,0 +1,54 @@
+#pragma once
+#include <miniaudio.h>
+#include <capo/buffer.hpp>
+#include <array>
+#include <optional>
+#include <span>
+
+#if defined(CAPO_OPUS)
+#include <extras/decoders/libopus/miniaudio_libopus.h>
+#endif
+
+namespace capo::detail {
+constexpr auto to_ma_encoding(std::optional<Encoding> const encoding) -> ma_encoding_format {
+	if (!encoding) { return ma_encoding_format_unknown; }
+	switch (*encoding) {
+	case Encoding::Wav: return ma_encoding_format_wav;
+	case Encoding::Mp3: return ma_encoding_format_mp3;
+	case Encoding::Flac: return ma_encoding_format_flac;
+	case Encoding::Vorbis: return ma_encoding_format_vorbis;
+	// Opus is provided by a custom decoding backend, which are tried first for unknown formats.
+	default: return ma_encoding_format_unknown;
+	}
+}
+
+/// \brief Custom decoding backends (libopus), empty if none are enabled.
+inline auto get_custom_backends() -> std::span<ma_decoding_backend_vtable*> {
+#if defined(CAPO_OPUS)
+	static auto ret = std::array{ma_decoding_backend_libopus};
+	return ret;
+#else
+	return {};
+#endif
+}
+
+inline void set_custom_backends(ma_decoder_config& out) {
+	auto const backends = get_custom_backends();
+	out.ppCustomBackendVTables = backends.data();
+	out.customBackendCount = ma_uint32(backends.size());
+}
+
+inline void set_custom_backends(ma_resource_manager_config& out) {
+	auto const backends = get_custom_backends();
+	out.ppCustomDecodingBackendVTables = backends.data();
+	out.customDecodingBackendCount = ma_uint32(backends.size());
+}
+
+/// \brief Check whether a decoder was initialized by a custom backend.
+inline auto is_custom_backend(ma_decoder const& decoder) -> bool {
+	for (auto const* vtable : get_custom_backends()) {
+		if (decoder.pBackendVTable == vtable) { return true; }
+	}
+	return false;
+}
+} // namespace capo::detail
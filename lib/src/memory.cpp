@@ -0,0 +1,184 @@
+#include <capo/memory.hpp>
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <utility>
+#include "ma_allocator.hpp"
+
+namespace capo {
+namespace {
+// process-wide counters, constant-initialized so that static Buffers can be charged in any order.
+class Tracker {
+  public:
+	void add(MemoryCategory const category, std::uint64_t const bytes) {
+		update_peak(m_total.fetch_add(bytes) + bytes);
+		m_bytes.at(std::size_t(category)).fetch_add(bytes);
+	}
+
+	void sub(MemoryCategory const category, std::uint64_t const bytes) {
+		m_bytes.at(std::size_t(category)).fetch_sub(bytes);
+		m_total.fetch_sub(bytes);
+	}
+
+	auto try_add(MemoryCategory const category, std::uint64_t const bytes) -> bool {
+		while (!try_reserve(bytes)) {
+			auto const evictor = get_evictor();
+			if (!evictor) { return false; }
+			auto const target = m_total.load() + bytes;
+			auto const max_bytes = m_max_bytes.load();
+			if (target > max_bytes && !evictor->evict(target - max_bytes)) { return false; }
+		}
+		m_bytes.at(std::size_t(category)).fetch_add(bytes);
+		return true;
+	}
+
+	[[nodiscard]] auto get_stats() const -> MemoryStats {
+		auto ret = MemoryStats{};
+		for (auto i = 0uz; i < m_bytes.size(); ++i) { ret.bytes.at(i) = m_bytes.at(i).load(); }
+		ret.total = m_total.load();
+		ret.peak = m_peak.load();
+		ret.budget = m_max_bytes.load();
+		return ret;
+	}
+
+	void set_budget(MemoryBudget budget) {
+		auto lock = std::scoped_lock{m_mutex};
+		m_max_bytes.store(budget.max_bytes);
+		m_evictor = std::move(budget.evictor);
+	}
+
+  private:
+	// adds to the total only if it stays within the budget.
+	auto try_reserve(std::uint64_t const bytes) -> bool {
+		auto total = m_total.load();
+		do {
+			auto const max_bytes = m_max_bytes.load();
+			if (max_bytes > 0 && total + bytes > max_bytes) { return false; }
+		} while (!m_total.compare_exchange_weak(total, total + bytes));
+		update_peak(total + bytes);
+		return true;
+	}
+
+	void update_peak(std::uint64_t const total) {
+		auto peak = m_peak.load();
+		while (total > peak && !m_peak.compare_exchange_weak(peak, total)) {}
+	}
+
+	// evictors are invoked without holding the lock, they may free Buffers or even set the budget.
+	[[nodiscard]] auto get_evictor() -> std::shared_ptr<IMemoryEvictor> {
+		auto lock = std::scoped_lock{m_mutex};
+		return m_evictor;
+	}
+
+	std::array<std::atomic<std::uint64_t>, memory_category_count_v> m_bytes{};
+	std::atomic<std::uint64_t> m_total{};
+	std::atomic<std::uint64_t> m_peak{};
+	std::atomic<std::uint64_t> m_max_bytes{};
+	std::mutex m_mutex{};
+	std::shared_ptr<IMemoryEvictor> m_evictor{};
+};
+
+constinit auto g_tracker = Tracker{};
+
+// allocations are prefixed with their size, so that frees can be discharged (and sized deallocation is possible).
+constexpr auto header_size_v = alignof(std::max_align_t);
+
+auto on_malloc(std::size_t const size, void* user_data) -> void* {
+	auto* context = static_cast<detail::AllocatorContext*>(user_data);
+	auto* resource = context == nullptr ? nullptr : context->resource;
+	auto const total_size = size + header_size_v;
+	auto* ptr = static_cast<std::byte*>(resource == nullptr ? std::malloc(total_size)
+															 : resource->allocate(total_size, header_size_v));
+	if (ptr == nullptr) { return nullptr; }
+	*reinterpret_cast<std::size_t*>(ptr) = size;
+	g_tracker.add(MemoryCategory::Miniaudio, size);
+	if (context != nullptr) { context->allocated.fetch_add(size); }
+	return ptr + header_size_v;
+}
+
+void on_free(void* ptr, void* user_data) {
+	if (ptr == nullptr) { return; }
+	auto* context = static_cast<detail::AllocatorContext*>(user_data);
+	auto* base = static_cast<std::byte*>(ptr) - header_size_v;
+	auto const size = *reinterpret_cast<std::size_t*>(base);
+	g_tracker.sub(MemoryCategory::Miniaudio, size);
+	if (context != nullptr) { context->allocated.fetch_sub(size); }
+	if (context == nullptr || context->resource == nullptr) {
+		std::free(base);
+		return;
+	}
+	context->resource->deallocate(base, size + header_size_v, header_size_v);
+}
+
+auto on_realloc(void* ptr, std::size_t const size, void* user_data) -> void* {
+	if (ptr == nullptr) { return on_malloc(size, user_data); }
+	auto* ret = on_malloc(size, user_data);
+	if (ret == nullptr) { return nullptr; }
+	auto const* base = static_cast<std::byte*>(ptr) - header_size_v;
+	auto const prev_size = *reinterpret_cast<std::size_t const*>(base);
+	std::memcpy(ret, ptr, std::min(size, prev_size));
+	on_free(ptr, user_data);
+	return ret;
+}
+} // namespace
+
+auto MemoryCharge::try_create(MemoryCategory const category, std::uint64_t const bytes)
+	-> std::optional<MemoryCharge> {
+	if (!g_tracker.try_add(category, bytes)) { return {}; }
+	auto ret = MemoryCharge{};
+	ret.m_category = category;
+	ret.m_bytes = bytes;
+	return ret;
+}
+
+MemoryCharge::MemoryCharge(MemoryCategory const category, std::uint64_t const bytes)
+	: m_category(category), m_bytes(bytes) {
+	g_tracker.add(m_category, m_bytes);
+}
+
+MemoryCharge::MemoryCharge(MemoryCharge const& rhs) : MemoryCharge(rhs.m_category, rhs.m_bytes) {}
+
+MemoryCharge::MemoryCharge(MemoryCharge&& rhs) noexcept
+	: m_category(rhs.m_category), m_bytes(std::exchange(rhs.m_bytes, 0)) {}
+
+auto MemoryCharge::operator=(MemoryCharge const& rhs) -> MemoryCharge& {
+	if (&rhs != this) { *this = MemoryCharge{rhs}; }
+	return *this;
+}
+
+auto MemoryCharge::operator=(MemoryCharge&& rhs) noexcept -> MemoryCharge& {
+	if (&rhs != this) {
+		g_tracker.sub(m_category, m_bytes);
+		m_category = rhs.m_category;
+		m_bytes = std::exchange(rhs.m_bytes, 0);
+	}
+	return *this;
+}
+
+MemoryCharge::~MemoryCharge() { g_tracker.sub(m_category, m_bytes); }
+
+void MemoryCharge::resize(std::uint64_t const bytes) {
+	if (bytes > m_bytes) {
+		g_tracker.add(m_category, bytes - m_bytes);
+	} else {
+		g_tracker.sub(m_category, m_bytes - bytes);
+	}
+	m_bytes = bytes;
+}
+
+auto detail::make_allocation_callbacks(AllocatorContext* context) -> ma_allocation_callbacks {
+	return ma_allocation_callbacks{
+		.pUserData = context,
+		.onMalloc = &on_malloc,
+		.onRealloc = &on_realloc,
+		.onFree = &on_free,
+	};
+}
+} // namespace capo
+
+auto capo::get_memory_stats() -> MemoryStats { return g_tracker.get_stats(); }
+
+void capo::set_memory_budget(MemoryBudget budget) { g_tracker.set_budget(std::move(budget)); }
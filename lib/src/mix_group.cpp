@@ -0,0 +1,232 @@
+#include <algorithm>
+#include <cassert>
+#include "effect_graph.hpp"
+#include "mix_group.hpp"
+#include "spsc_ring.hpp"
+#include "trace.hpp"
+
+namespace capo {
+namespace {
+// frames buffered ahead are bounded by the ring, and are mixed in chunks of the scratch buffer.
+constexpr auto ring_frames_v = 16384uz;
+constexpr auto chunk_frames_v = 1024u;
+
+class MixGroup : public IMixGroup, public detail::MixJob {
+  public:
+	MixGroup(MixGroup const&) = delete;
+	MixGroup(MixGroup&&) = delete;
+	auto operator=(MixGroup const&) -> MixGroup& = delete;
+	auto operator=(MixGroup&&) -> MixGroup& = delete;
+
+	explicit MixGroup(ma_engine& engine, detail::MixScheduler& scheduler)
+		: m_engine(engine), m_scheduler(scheduler), m_channels(ma_engine_get_channels(&engine)),
+		  m_ring(ring_frames_v * m_channels), m_scratch(std::size_t(chunk_frames_v) * m_channels) {}
+
+	~MixGroup() override {
+		// detach from the audio thread first, then from the workers.
+		if (m_node_ready) { ma_node_uninit(&m_node, &m_engine.allocationCallbacks); }
+		if (m_slot) { m_scheduler.remove(*m_slot); }
+		if (m_graph_ready) { ma_node_graph_uninit(&m_graph, &m_engine.allocationCallbacks); }
+	}
+
+	auto init() -> bool {
+		auto const graph_config = ma_node_graph_config_init(m_channels);
+		if (ma_node_graph_init(&graph_config, &m_engine.allocationCallbacks, &m_graph) != MA_SUCCESS) { return false; }
+		m_graph_ready = true;
+
+		auto config = ma_node_config_init();
+		config.vtable = &s_vtable;
+		config.pOutputChannels = &m_channels;
+		auto* graph = ma_engine_get_node_graph(&m_engine);
+		if (ma_node_init(graph, &config, &m_engine.allocationCallbacks, &m_node) != MA_SUCCESS) { return false; }
+		m_node.group = this;
+		m_node_ready = true;
+
+		m_slot = m_scheduler.add(*this);
+		if (!m_slot) { return false; }
+		ma_node_attach_output_bus(&m_node, 0, detail::get_input_node(m_engine, nullptr), 0);
+		return true;
+	}
+
+	[[nodiscard]] auto get_gain() const -> float final { return ma_node_get_output_bus_volume(&m_node, 0); }
+	void set_gain(float const gain) final { ma_node_set_output_bus_volume(&m_node, 0, std::max(gain, 0.0f)); }
+
+	[[nodiscard]] auto get_output() const -> IEffect* final { return m_output; }
+
+	void set_output(IEffect* effect) final {
+		m_output = effect;
+		ma_node_attach_output_bus(&m_node, 0, detail::get_input_node(m_engine, effect), 0);
+	}
+
+	[[nodiscard]] auto get_underrun_count() const -> std::uint64_t final { return m_underruns.load(); }
+
+	[[nodiscard]] auto get_input_node() -> ma_node* { return ma_node_graph_get_endpoint(&m_graph); }
+
+	// called by whichever thread claimed this job.
+	void mix(std::uint32_t const target) final {
+		CAPO_TRACE_SCOPE("MixGroup::mix");
+		auto const target_frames = std::min(std::size_t(target), ring_frames_v);
+		while (true) {
+			auto const buffered = m_ring.get_size() / m_channels;
+			if (buffered >= target_frames) { return; }
+			auto const free = m_ring.get_free() / m_channels;
+			auto const frames = std::min({target_frames - buffered, free, std::size_t(chunk_frames_v)});
+			if (frames == 0) { return; }
+			auto read = ma_uint64{};
+			ma_node_graph_read_pcm_frames(&m_graph, m_scratch.data(), frames, &read);
+			if (read == 0) { return; }
+			m_ring.write(std::span{m_scratch}.subspan(0, std::size_t(read) * m_channels));
+		}
+	}
+
+  private:
+	struct Node : ma_node_base {
+		MixGroup* group{};
+	};
+
+	// called on the audio thread.
+	// if a worker is still mixing this group, only what is already buffered is output (the rest is silence).
+	void process(std::span<float> out) {
+		if (m_ring.get_size() < out.size()) {
+			m_underruns.fetch_add(1, std::memory_order_relaxed);
+			std::ignore = m_scheduler.run_now(*m_slot, std::uint32_t(out.size() / m_channels));
+		}
+		auto const count = std::min(out.size(), m_ring.get_size());
+		m_ring.read(out.subspan(0, count));
+		std::ranges::fill(out.subspan(count), 0.0f);
+	}
+
+	static ma_node_vtable const s_vtable;
+
+	ma_engine& m_engine;
+	detail::MixScheduler& m_scheduler;
+	ma_uint32 m_channels{};
+	IEffect* m_output{};
+
+	// produced by the claiming thread, consumed by the audio thread.
+	detail::SpscRing<float> m_ring;
+	std::vector<float> m_scratch{};
+	std::atomic<std::uint64_t> m_underruns{};
+
+	ma_node_graph m_graph{};
+	Node m_node{};
+	std::optional<std::size_t> m_slot{};
+	bool m_graph_ready{};
+	bool m_node_ready{};
+};
+
+// source node (no inputs): pulls pre-mixed frames.
+ma_node_vtable const MixGroup::s_vtable = {
+	.onProcess = [](ma_node* node, float const** /*frames_in*/, ma_uint32* /*frame_count_in*/, float** frames_out,
+					ma_uint32* frame_count_out) {
+		auto& self = *static_cast<Node*>(node)->group;
+		self.process(std::span{frames_out[0], std::size_t(*frame_count_out) * self.m_channels});
+	},
+	.onGetRequiredInputFrameCount = nullptr,
+	.inputBusCount = 0,
+	.outputBusCount = 1,
+	.flags = {},
+};
+} // namespace
+
+namespace detail {
+MixScheduler::MixScheduler(std::uint32_t thread_count) {
+	if (thread_count == 0) { thread_count = std::max(std::thread::hardware_concurrency(), 2u) - 1; }
+	m_workers.reserve(thread_count);
+	for (auto i = 0uz; i < thread_count; ++i) {
+		// workers start scanning at different slots, to spread out claims.
+		auto const first = (i * max_jobs_v) / thread_count;
+		m_workers.emplace_back([this, first](std::stop_token const& stop) { work(stop, first); });
+	}
+}
+
+MixScheduler::~MixScheduler() {
+	for (auto& worker : m_workers) { worker.request_stop(); }
+	m_epoch.fetch_add(1);
+	m_epoch.notify_all();
+}
+
+auto MixScheduler::add(MixJob& job) -> std::optional<std::size_t> {
+	for (auto i = 0uz; i < m_slots.size(); ++i) {
+		auto& slot = m_slots.at(i);
+		auto expected = std::uint32_t{Free};
+		// reserve the slot (as Running) before publishing the job.
+		if (!slot.state.compare_exchange_strong(expected, Running)) { continue; }
+		slot.job = &job;
+		slot.state.store(Idle, std::memory_order_release);
+		return i;
+	}
+	return {};
+}
+
+void MixScheduler::remove(std::size_t const index) {
+	auto& slot = m_slots.at(index);
+	while (true) {
+		auto state = slot.state.load();
+		if (state == Running) {
+			slot.state.wait(Running);
+			continue;
+		}
+		if (slot.state.compare_exchange_strong(state, Free)) { break; }
+	}
+	slot.job = nullptr;
+}
+
+void MixScheduler::dispatch(std::uint32_t const frame_count) {
+	m_frame_count.store(frame_count, std::memory_order_relaxed);
+	auto any = false;
+	for (auto& slot : m_slots) { any |= transition(slot, Idle, Pending); }
+	if (!any) { return; }
+	m_epoch.fetch_add(1, std::memory_order_release);
+	m_epoch.notify_all();
+}
+
+auto MixScheduler::run_now(std::size_t const index, std::uint32_t const target) -> bool {
+	auto& slot = m_slots.at(index);
+	// claim a pending / idle job: never wait for a (lower priority) worker that is running it.
+	if (!transition(slot, Pending, Running) && !transition(slot, Idle, Running)) { return false; }
+	run(slot, target);
+	return true;
+}
+
+void MixScheduler::work(std::stop_token const& stop, std::size_t const first) {
+	auto epoch = m_epoch.load(std::memory_order_acquire);
+	while (!stop.stop_requested()) {
+		auto claimed = false;
+		for (auto i = 0uz; i < m_slots.size(); ++i) {
+			auto& slot = m_slots.at((first + i) % m_slots.size());
+			if (!transition(slot, Pending, Running)) { continue; }
+			run(slot, m_frame_count.load(std::memory_order_relaxed));
+			claimed = true;
+		}
+		// rescan until no pending jobs remain, then sleep until the next dispatch.
+		if (claimed) { continue; }
+		m_epoch.wait(epoch, std::memory_order_acquire);
+		epoch = m_epoch.load(std::memory_order_acquire);
+	}
+}
+
+auto MixScheduler::transition(Slot& slot, State const from, State const to) -> bool {
+	auto expected = std::uint32_t{from};
+	return slot.state.compare_exchange_strong(expected, to, std::memory_order_acq_rel);
+}
+
+void MixScheduler::run(Slot& slot, std::uint32_t const target) {
+	assert(slot.job != nullptr);
+	slot.job->mix(target);
+	slot.state.store(Idle, std::memory_order_release);
+	slot.state.notify_all();
+}
+} // namespace detail
+
+auto detail::create_mix_group(ma_engine& engine, MixScheduler& scheduler) -> std::unique_ptr<IMixGroup> {
+	auto ret = std::make_unique<MixGroup>(engine, scheduler);
+	if (!ret->init()) { return {}; }
+	return ret;
+}
+
+auto detail::get_input_node(IMixGroup& group) -> ma_node* {
+	// all MixGroups are created by create_mix_group().
+	return static_cast<MixGroup&>(group).get_input_node();
+}
+} // namespace capo
@@ -0,0 +1,75 @@
+#pragma once
+#include <miniaudio.h>
+#include <capo/mix_group.hpp>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <thread>
+#include <vector>
+
+namespace capo::detail {
+/// \brief Unit of work mixed ahead of the audio thread by a MixScheduler.
+class MixJob : public Polymorphic {
+  public:
+	/// \brief Mix until at least target frames are buffered.
+	virtual void mix(std::uint32_t target) = 0;
+};
+
+/// \brief Pool of worker threads that run MixJobs, once per audio callback.
+/// Jobs live in a fixed table of slots: dispatch marks them pending, and any idle worker claims the next pending one.
+/// The audio thread can claim a job itself if it needs its output before a worker got to it.
+class MixScheduler {
+  public:
+	static constexpr auto max_jobs_v = 64uz;
+
+	MixScheduler(MixScheduler const&) = delete;
+	MixScheduler(MixScheduler&&) = delete;
+	auto operator=(MixScheduler const&) -> MixScheduler& = delete;
+	auto operator=(MixScheduler&&) -> MixScheduler& = delete;
+
+	/// \param thread_count Number of worker threads, 0 for hardware concurrency - 1.
+	explicit MixScheduler(std::uint32_t thread_count);
+	~MixScheduler();
+
+	/// \returns Slot index, nullopt if all slots are taken.
+	[[nodiscard]] auto add(MixJob& job) -> std::optional<std::size_t>;
+	/// \brief Remove a job, waiting for it to finish if running.
+	void remove(std::size_t index);
+
+	/// \brief Mark all jobs pending and wake workers, called on the audio thread after each callback.
+	/// \param frame_count Frames to mix ahead, ie the size of the next callback.
+	void dispatch(std::uint32_t frame_count);
+	/// \brief Run a job on the calling (audio) thread, unless a worker is running it (which is never waited for).
+	/// \param target Frames that must be buffered.
+	/// \returns false if the job was not run.
+	[[nodiscard]] auto run_now(std::size_t index, std::uint32_t target) -> bool;
+
+  private:
+	enum State : std::uint32_t { Free, Idle, Pending, Running };
+
+	struct Slot {
+		std::atomic<std::uint32_t> state{Free};
+		MixJob* job{};
+	};
+
+	void work(std::stop_token const& stop, std::size_t first);
+	auto transition(Slot& slot, State from, State to) -> bool;
+	void run(Slot& slot, std::uint32_t target);
+
+	std::array<Slot, max_jobs_v> m_slots{};
+	std::atomic<std::uint32_t> m_frame_count{};
+	std::atomic<std::uint64_t> m_epoch{};
+	std::vector<std::jthread> m_workers{};
+};
+
+/// \brief Create a MixGroup, outputting directly to the engine's endpoint.
+/// \returns null on failure.
+[[nodiscard]] auto create_mix_group(ma_engine& engine, MixScheduler& scheduler) -> std::unique_ptr<IMixGroup>;
+
+/// \brief Obtain the node that Sources in a MixGroup attach to.
+/// \param group MixGroup created by create_mix_group().
+[[nodiscard]] auto get_input_node(IMixGroup& group) -> ma_node*;
+} // namespace capo::detail
@@ -0,0 +1,68 @@
+#pragma once
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <memory>
+#include <optional>
+
+namespace capo::detail {
+/// \brief Bounded lock-free multi-producer single-consumer queue.
+/// Each slot carries a sequence number that producers claim via CAS on the tail (Vyukov).
+/// Capacity is rounded up to a power of 2.
+template <typename Type>
+class MpscQueue {
+  public:
+	explicit MpscQueue(std::size_t const capacity)
+		: m_slots(std::make_unique<Slot[]>(std::bit_ceil(capacity))), m_mask(std::bit_ceil(capacity) - 1) {
+		for (auto i = 0uz; i <= m_mask; ++i) { m_slots[i].sequence.store(i, std::memory_order_relaxed); }
+	}
+
+	/// \brief Push a value, safe to call from any thread.
+	/// value is only moved from on success.
+	/// \returns false if the queue is full.
+	[[nodiscard]] auto try_push(Type&& value) -> bool {
+		auto tail = m_tail.load(std::memory_order_relaxed);
+		while (true) {
+			auto& slot = m_slots[tail & m_mask];
+			auto const sequence = slot.sequence.load(std::memory_order_acquire);
+			if (sequence == tail) {
+				if (m_tail.compare_exchange_weak(tail, tail + 1, std::memory_order_relaxed)) {
+					slot.value.emplace(std::move(value));
+					slot.sequence.store(tail + 1, std::memory_order_release);
+					return true;
+				}
+			} else if (sequence < tail) {
+				return false;
+			} else {
+				tail = m_tail.load(std::memory_order_relaxed);
+			}
+		}
+	}
+
+	/// \brief Pop the oldest value, must only be called from the consumer thread.
+	/// \returns nullopt if the queue is empty.
+	[[nodiscard]] auto try_pop() -> std::optional<Type> {
+		auto& slot = m_slots[m_head & m_mask];
+		if (slot.sequence.load(std::memory_order_acquire) != m_head + 1) { return {}; }
+		auto ret = std::move(slot.value);
+		slot.value.reset();
+		slot.sequence.store(m_head + m_mask + 1, std::memory_order_release);
+		++m_head;
+		return ret;
+	}
+
+  private:
+	struct Slot {
+		std::atomic<std::size_t> sequence{};
+		std::optional<Type> value{};
+	};
+
+	// avoid false sharing between producers and the consumer.
+	static constexpr auto cache_line_v = 64uz;
+
+	std::unique_ptr<Slot[]> m_slots{};
+	std::size_t m_mask{};
+	alignas(cache_line_v) std::atomic<std::size_t> m_tail{};
+	alignas(cache_line_v) std::size_t m_head{};
+};
+} // namespace capo::detail
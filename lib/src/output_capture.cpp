@@ -0,0 +1,69 @@
+#include <capo/memory.hpp>
+#include <algorithm>
+#include <atomic>
+#include "output_capture.hpp"
+#include "spsc_ring.hpp"
+
+namespace capo {
+namespace {
+class OutputCapture : public IOutputCapture {
+  public:
+	explicit OutputCapture(std::uint32_t const sample_rate, std::uint8_t const channels, std::size_t const frames)
+		: m_sample_rate(sample_rate), m_channels(channels), m_ring(frames * channels),
+		  m_charge(MemoryCategory::StreamBuffers, m_ring.get_capacity() * sizeof(float)) {}
+
+	[[nodiscard]] auto get_sample_rate() const -> std::uint32_t final { return m_sample_rate; }
+	[[nodiscard]] auto get_channels() const -> std::uint8_t final { return m_channels; }
+
+	[[nodiscard]] auto read_samples(std::span<float> out) -> std::size_t final {
+		auto const count = to_whole_frames(std::min(out.size(), m_ring.get_size()));
+		m_ring.read(out.subspan(0, count));
+		return count;
+	}
+
+	[[nodiscard]] auto get_available_samples() const -> std::size_t final { return m_ring.get_size(); }
+	[[nodiscard]] auto get_captured_frames() const -> std::uint64_t final { return m_captured.load(); }
+	[[nodiscard]] auto get_dropped_frames() const -> std::uint64_t final { return m_dropped.load(); }
+	[[nodiscard]] auto get_overflow_count() const -> std::uint64_t final { return m_overflows.load(); }
+
+	void clear() final { m_ring.clear(); }
+
+	// called on the audio thread.
+	void write(std::span<float const> samples) {
+		auto const count = to_whole_frames(std::min(samples.size(), m_ring.get_free()));
+		m_ring.write(samples.subspan(0, count));
+		auto const frames = samples.size() / m_channels;
+		m_captured.fetch_add(frames, std::memory_order_relaxed);
+		if (count == samples.size()) { return; }
+		m_dropped.fetch_add(frames - (count / m_channels), std::memory_order_relaxed);
+		m_overflows.fetch_add(1, std::memory_order_relaxed);
+	}
+
+  private:
+	[[nodiscard]] auto to_whole_frames(std::size_t const samples) const -> std::size_t {
+		return samples - (samples % m_channels);
+	}
+
+	std::uint32_t m_sample_rate{};
+	std::uint8_t m_channels{};
+	detail::SpscRing<float> m_ring;
+	MemoryCharge m_charge;
+
+	std::atomic<std::uint64_t> m_captured{};
+	std::atomic<std::uint64_t> m_dropped{};
+	std::atomic<std::uint64_t> m_overflows{};
+};
+} // namespace
+
+auto detail::create_output_capture(std::uint32_t const sample_rate, std::uint8_t const channels,
+								   OutputCaptureCreateInfo const& create_info) -> std::unique_ptr<IOutputCapture> {
+	if (sample_rate == 0 || channels == 0) { return {}; }
+	auto const capacity = std::max(create_info.capacity, std::chrono::milliseconds{1});
+	auto const frames = std::size_t(capacity.count()) * sample_rate / 1000;
+	return std::make_unique<OutputCapture>(sample_rate, channels, frames);
+}
+
+void detail::capture_output(IOutputCapture& capture, std::span<float const> samples) {
+	static_cast<OutputCapture&>(capture).write(samples);
+}
+} // namespace capo
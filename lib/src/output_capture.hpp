@@ -0,0 +1,16 @@
+#pragma once
+#include <capo/output_capture.hpp>
+#include <cstdint>
+#include <memory>
+#include <span>
+
+namespace capo::detail {
+/// \brief Create an OutputCapture for an engine's output format.
+[[nodiscard]] auto create_output_capture(std::uint32_t sample_rate, std::uint8_t channels,
+										 OutputCaptureCreateInfo const& create_info)
+	-> std::unique_ptr<IOutputCapture>;
+
+/// \brief Copy interleaved frames of the engine's output, must only be called on the audio thread.
+/// \param capture OutputCapture created by create_output_capture().
+void capture_output(IOutputCapture& capture, std::span<float const> samples);
+} // namespace capo::detail
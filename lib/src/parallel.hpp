@@ -0,0 +1,29 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+namespace capo::detail {
+/// \brief Invoke func(index) for each index in [0, count), spread across worker threads.
+/// Workers pull the next index, so items of varying cost balance themselves across cores.
+/// The calling thread participates as one of the workers.
+/// \param thread_count Number of threads, 0 for hardware concurrency.
+template <typename F>
+void parallel_for(std::size_t const count, std::uint32_t thread_count, F func) {
+	if (count == 0) { return; }
+	if (thread_count == 0) { thread_count = std::max(std::thread::hardware_concurrency(), 1u); }
+	thread_count = std::uint32_t(std::min(std::size_t(thread_count), count));
+
+	auto next = std::atomic<std::size_t>{};
+	auto const work = [&] {
+		for (auto i = next.fetch_add(1); i < count; i = next.fetch_add(1)) { func(i); }
+	};
+	auto workers = std::vector<std::jthread>{};
+	workers.reserve(thread_count - 1);
+	for (auto i = 1u; i < thread_count; ++i) { workers.emplace_back(work); }
+	work();
+}
+} // namespace capo::detail
@@ -0,0 +1,370 @@
+#include <capo/pcm_cache.hpp>
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <random>
+#include <span>
+#include <string_view>
+#include <vector>
+#include "trace.hpp"
+
+#if __has_include(<sys/mman.h>)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define CAPO_PCM_CACHE_MMAP
+#endif
+
+namespace capo {
+namespace {
+namespace fs = std::filesystem;
+
+constexpr auto magic_v = std::array{'c', 'a', 'p', 'o', '-', 'p', 'c', 'm'};
+constexpr auto version_v = std::uint32_t{1};
+constexpr auto alignment_v = 64u;
+constexpr auto max_channels_v = 16uz;
+constexpr auto extension_v = std::string_view{".pcm"};
+
+// layout of an entry: Header, source path, padding to alignment_v, interleaved f32 samples.
+struct Header {
+	std::array<char, 8> magic{};
+	std::uint32_t version{};
+	std::uint32_t data_offset{};
+	std::uint64_t source_size{};
+	std::int64_t source_mtime{};
+	std::uint64_t content_hash{};
+	std::uint64_t frame_count{};
+	std::uint32_t sample_rate{};
+	std::uint32_t path_size{};
+	std::uint8_t channels{};
+	std::array<Channel, max_channels_v> channel_map{};
+	std::array<std::uint8_t, 7> reserved{};
+};
+static_assert(sizeof(Header) % 8 == 0 && std::is_trivially_copyable_v<Header>);
+
+// FNV-1a.
+[[nodiscard]] constexpr auto hash_bytes(std::span<std::byte const> bytes) -> std::uint64_t {
+	auto ret = std::uint64_t{0xcbf29ce484222325};
+	for (auto const byte : bytes) {
+		ret ^= std::uint64_t(byte);
+		ret *= 0x100000001b3;
+	}
+	return ret;
+}
+
+[[nodiscard]] auto hash_string(std::string_view const str) -> std::uint64_t {
+	return hash_bytes(std::as_bytes(std::span{str}));
+}
+
+[[nodiscard]] constexpr auto align_up(std::uint64_t const value) -> std::uint64_t {
+	return (value + alignment_v - 1) / alignment_v * alignment_v;
+}
+
+struct SourceInfo {
+	std::uint64_t size{};
+	std::int64_t mtime{};
+};
+
+[[nodiscard]] auto get_source_info(fs::path const& path) -> std::optional<SourceInfo> {
+	auto ec = std::error_code{};
+	auto const size = fs::file_size(path, ec);
+	if (ec) { return {}; }
+	auto const mtime = fs::last_write_time(path, ec);
+	if (ec) { return {}; }
+	return SourceInfo{.size = size, .mtime = std::int64_t(mtime.time_since_epoch().count())};
+}
+
+// read-only view of a whole file, memory-mapped where supported.
+class MappedFile {
+  public:
+	MappedFile(MappedFile const&) = delete;
+	MappedFile(MappedFile&&) = delete;
+	auto operator=(MappedFile const&) -> MappedFile& = delete;
+	auto operator=(MappedFile&&) -> MappedFile& = delete;
+
+	explicit MappedFile(fs::path const& path) {
+#if defined(CAPO_PCM_CACHE_MMAP)
+		auto const fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+		if (fd < 0) { return; }
+		struct stat info{};
+		if (::fstat(fd, &info) == 0 && info.st_size > 0) {
+			auto const size = std::size_t(info.st_size);
+			auto* data = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+			if (data != MAP_FAILED) {
+				// advice values are not flags: each needs its own call.
+				::madvise(data, size, MADV_SEQUENTIAL);
+				::madvise(data, size, MADV_WILLNEED);
+				m_bytes = std::span{static_cast<std::byte const*>(data), size};
+			}
+		}
+		::close(fd);
+#else
+		auto file = std::ifstream{path, std::ios::binary | std::ios::ate};
+		if (!file) { return; }
+		m_storage.resize(std::size_t(file.tellg()));
+		file.seekg(0, std::ios::beg);
+		void* data = m_storage.data();
+		if (!file.read(static_cast<char*>(data), std::streamsize(m_storage.size()))) { m_storage.clear(); }
+		m_bytes = m_storage;
+#endif
+	}
+
+	~MappedFile() {
+#if defined(CAPO_PCM_CACHE_MMAP)
+		if (!m_bytes.empty()) { ::munmap(const_cast<std::byte*>(m_bytes.data()), m_bytes.size()); }
+#endif
+	}
+
+	[[nodiscard]] auto get_bytes() const -> std::span<std::byte const> { return m_bytes; }
+
+  private:
+	std::span<std::byte const> m_bytes{};
+#if !defined(CAPO_PCM_CACHE_MMAP)
+	std::vector<std::byte> m_storage{};
+#endif
+};
+
+class PcmCache : public IPcmCache {
+  public:
+	explicit PcmCache(PcmCacheCreateInfo create_info)
+		: m_directory(std::move(create_info.directory)), m_max_bytes(create_info.max_bytes) {
+		for (auto const& entry : list_entries()) {
+			++m_stats.entry_count;
+			m_stats.size_bytes += entry.size;
+		}
+	}
+
+	[[nodiscard]] auto get_directory() const -> std::string const& final { return m_directory; }
+
+	[[nodiscard]] auto get_stats() const -> PcmCacheStats final {
+		auto lock = std::scoped_lock{m_mutex};
+		return m_stats;
+	}
+
+	[[nodiscard]] auto load(Buffer& out, char const* path, std::optional<Encoding> encoding) -> bool final {
+		if (path == nullptr || *path == '\0') { return false; }
+		auto ec = std::error_code{};
+		auto const source = fs::absolute(path, ec);
+		if (ec) { return false; }
+		auto const source_info = get_source_info(source);
+		if (!source_info) { return false; }
+
+		auto const key = source.generic_string();
+		auto const entry_path = get_entry_path(key);
+		if (try_load(out, entry_path, key, *source_info)) {
+			auto lock = std::scoped_lock{m_mutex};
+			++m_stats.hits;
+			return true;
+		}
+
+		auto const bytes = file_to_bytes(path);
+		if (bytes.empty()) { return false; }
+		if (!encoding) { encoding = guess_encoding(path); }
+		if (!out.decode_bytes(bytes, encoding)) { return false; }
+		{
+			auto lock = std::scoped_lock{m_mutex};
+			++m_stats.misses;
+		}
+		store(out, entry_path, key, *source_info, hash_bytes(bytes));
+		return true;
+	}
+
+	void invalidate(char const* path) final {
+		if (path == nullptr) { return; }
+		auto ec = std::error_code{};
+		auto const source = fs::absolute(path, ec);
+		if (ec) { return; }
+		remove_entry(get_entry_path(source.generic_string()));
+	}
+
+	void clear() final {
+		for (auto const& entry : list_entries()) { remove_entry(entry.path); }
+	}
+
+  private:
+	struct Entry {
+		fs::path path{};
+		std::uint64_t size{};
+		fs::file_time_type last_used{};
+	};
+
+	[[nodiscard]] auto get_entry_path(std::string_view const key) const -> fs::path {
+		auto name = std::array<char, 16>{};
+		auto hash = hash_string(key);
+		for (auto it = name.rbegin(); it != name.rend(); ++it, hash >>= 4) { *it = "0123456789abcdef"[hash & 0xf]; }
+		return fs::path{m_directory} / (std::string{name.data(), name.size()} + std::string{extension_v});
+	}
+
+	[[nodiscard]] auto list_entries() const -> std::vector<Entry> {
+		auto ret = std::vector<Entry>{};
+		auto ec = std::error_code{};
+		for (auto const& it : fs::directory_iterator{m_directory, ec}) {
+			if (!it.is_regular_file(ec) || it.path().extension() != extension_v) { continue; }
+			auto entry = Entry{.path = it.path(), .size = it.file_size(ec), .last_used = it.last_write_time(ec)};
+			if (!ec) { ret.push_back(std::move(entry)); }
+		}
+		return ret;
+	}
+
+	auto try_load(Buffer& out, fs::path const& entry_path, std::string_view const key, SourceInfo const& source_info)
+		-> bool {
+		CAPO_TRACE_SCOPE("PcmCache::try_load");
+		auto const file = MappedFile{entry_path};
+		auto const bytes = file.get_bytes();
+		if (bytes.size() < sizeof(Header)) { return false; }
+		auto header = Header{};
+		std::memcpy(&header, bytes.data(), sizeof(Header));
+		if (header.magic != magic_v || header.version != version_v || header.sample_rate != Buffer::sample_rate_v ||
+			header.channels == 0 || header.channels > max_channels_v ||
+			header.data_offset < sizeof(Header) + header.path_size) {
+			return false;
+		}
+		auto const sample_count = header.frame_count * header.channels;
+		if (bytes.size() < header.data_offset + (sample_count * sizeof(float))) { return false; }
+		auto const* path_data = reinterpret_cast<char const*>(bytes.data() + sizeof(Header));
+		// different path with the same hash.
+		if (std::string_view{path_data, header.path_size} != key) { return false; }
+
+		if (header.source_size != source_info.size || header.source_mtime != source_info.mtime) {
+			if (!is_content_unchanged(key, header, source_info)) {
+				invalidate_entry(entry_path);
+				return false;
+			}
+			// only touched: refresh the stored modification time so that the next load skips hashing.
+			update_mtime(entry_path, source_info.mtime);
+		}
+
+		auto charge = MemoryCharge::try_create(MemoryCategory::DecodedPcm, sample_count * sizeof(float));
+		if (!charge) { return false; }
+		auto const* first = reinterpret_cast<float const*>(bytes.data() + header.data_offset);
+		auto samples = std::pmr::vector<float>{first, first + sample_count, out.get_memory_resource()};
+		auto const channel_map = std::span{header.channel_map}.subspan(0, header.channels);
+		out.set_frames(std::move(samples), channel_map);
+
+		// least recently used entries are evicted first.
+		auto ec = std::error_code{};
+		fs::last_write_time(entry_path, fs::file_time_type::clock::now(), ec);
+		return true;
+	}
+
+	[[nodiscard]] static auto is_content_unchanged(std::string_view const key, Header const& header,
+												   SourceInfo const& source_info) -> bool {
+		if (header.source_size != source_info.size) { return false; }
+		auto const source = MappedFile{fs::path{key}};
+		return hash_bytes(source.get_bytes()) == header.content_hash;
+	}
+
+	static void update_mtime(fs::path const& entry_path, std::int64_t const mtime) {
+		auto file = std::fstream{entry_path, std::ios::binary | std::ios::in | std::ios::out};
+		file.seekp(std::streamoff(offsetof(Header, source_mtime)));
+		file.write(reinterpret_cast<char const*>(&mtime), sizeof(mtime));
+	}
+
+	void store(Buffer const& buffer, fs::path const& entry_path, std::string_view const key,
+			   SourceInfo const& source_info, std::uint64_t const content_hash) {
+		CAPO_TRACE_SCOPE("PcmCache::store");
+		auto const channels = buffer.get_channels();
+		if (channels > max_channels_v) { return; }
+		auto header = Header{
+			.magic = magic_v,
+			.version = version_v,
+			.source_size = source_info.size,
+			.source_mtime = source_info.mtime,
+			.content_hash = content_hash,
+			.frame_count = buffer.get_frame_count(),
+			.sample_rate = Buffer::sample_rate_v,
+			.path_size = std::uint32_t(key.size()),
+			.channels = channels,
+		};
+		std::ranges::copy(buffer.get_channel_map(), header.channel_map.begin());
+		header.data_offset = std::uint32_t(align_up(sizeof(Header) + key.size()));
+		auto const samples = std::as_bytes(buffer.get_samples());
+		auto const entry_size = header.data_offset + samples.size();
+		if (entry_size > m_max_bytes) { return; }
+
+		// write to a temporary file and rename, so that concurrent loads never see partial entries.
+		auto temp_path = entry_path;
+		temp_path += ".tmp" + std::to_string(std::random_device{}());
+		{
+			auto file = std::ofstream{temp_path, std::ios::binary | std::ios::trunc};
+			auto const padding = std::array<char, alignment_v>{};
+			file.write(reinterpret_cast<char const*>(&header), sizeof(Header));
+			file.write(key.data(), std::streamsize(key.size()));
+			file.write(padding.data(), std::streamsize(header.data_offset - sizeof(Header) - key.size()));
+			file.write(reinterpret_cast<char const*>(samples.data()), std::streamsize(samples.size()));
+			if (!file) {
+				auto ec = std::error_code{};
+				fs::remove(temp_path, ec);
+				return;
+			}
+		}
+
+		auto lock = std::scoped_lock{m_mutex};
+		auto ec = std::error_code{};
+		if (auto const prev_size = fs::file_size(entry_path, ec); !ec) {
+			--m_stats.entry_count;
+			m_stats.size_bytes -= std::min(prev_size, m_stats.size_bytes);
+		}
+		evict(entry_size);
+		fs::rename(temp_path, entry_path, ec);
+		if (ec) {
+			fs::remove(temp_path, ec);
+			return;
+		}
+		++m_stats.entry_count;
+		m_stats.size_bytes += entry_size;
+	}
+
+	// must be called with m_mutex locked.
+	void evict(std::uint64_t const incoming) {
+		if (m_stats.size_bytes + incoming <= m_max_bytes) { return; }
+		auto entries = list_entries();
+		std::ranges::sort(entries, [](Entry const& a, Entry const& b) { return a.last_used < b.last_used; });
+		for (auto const& entry : entries) {
+			if (m_stats.size_bytes + incoming <= m_max_bytes) { break; }
+			auto ec = std::error_code{};
+			if (!fs::remove(entry.path, ec)) { continue; }
+			--m_stats.entry_count;
+			m_stats.size_bytes -= std::min(entry.size, m_stats.size_bytes);
+			++m_stats.evictions;
+		}
+	}
+
+	void invalidate_entry(fs::path const& entry_path) {
+		if (remove_entry(entry_path)) {
+			auto lock = std::scoped_lock{m_mutex};
+			++m_stats.invalidations;
+		}
+	}
+
+	auto remove_entry(fs::path const& entry_path) -> bool {
+		auto lock = std::scoped_lock{m_mutex};
+		auto ec = std::error_code{};
+		auto const size = fs::file_size(entry_path, ec);
+		if (ec || !fs::remove(entry_path, ec)) { return false; }
+		--m_stats.entry_count;
+		m_stats.size_bytes -= std::min(size, m_stats.size_bytes);
+		return true;
+	}
+
+	std::string m_directory{};
+	std::uint64_t m_max_bytes{};
+
+	mutable std::mutex m_mutex{};
+	PcmCacheStats m_stats{};
+};
+} // namespace
+} // namespace capo
+
+auto capo::create_pcm_cache(PcmCacheCreateInfo create_info) -> std::unique_ptr<IPcmCache> {
+	if (create_info.directory.empty()) { return {}; }
+	auto ec = std::error_code{};
+	fs::create_directories(create_info.directory, ec);
+	if (ec || !fs::is_directory(create_info.directory, ec)) { return {}; }
+	return std::make_unique<PcmCache>(std::move(create_info));
+}
@@ -0,0 +1,277 @@
+#include <miniaudio.h>
+#include <capo/probe.hpp>
+#include <array>
+#include <fstream>
+#include "ma_allocator.hpp"
+#include "ma_encoding.hpp"
+#include "parallel.hpp"
+
+namespace capo {
+namespace {
+constexpr auto all_encodings_v =
+	std::array{Encoding::Wav, Encoding::Flac, Encoding::Mp3, Encoding::Vorbis, Encoding::Opus};
+
+// enough to hold the first MPEG frame header and its Xing / Info / VBRI tag.
+constexpr auto mp3_head_size_v = 4uz /*KiB*/ * 1024uz /*B*/;
+
+[[nodiscard]] constexpr auto to_u8(std::byte const b) -> std::uint32_t { return std::to_integer<std::uint32_t>(b); }
+
+[[nodiscard]] constexpr auto read_u32_be(std::span<std::byte const> bytes) -> std::uint32_t {
+	return (to_u8(bytes[0]) << 24u) | (to_u8(bytes[1]) << 16u) | (to_u8(bytes[2]) << 8u) | to_u8(bytes[3]);
+}
+
+// size of a leading ID3v2 tag (which may contain large embedded images), 0 if none.
+[[nodiscard]] auto get_id3v2_size(std::span<std::byte const> bytes) -> std::uint64_t {
+	static constexpr auto header_size_v = 10uz;
+	if (bytes.size() < header_size_v) { return 0; }
+	if (to_u8(bytes[0]) != 'I' || to_u8(bytes[1]) != 'D' || to_u8(bytes[2]) != '3') { return 0; }
+	// syncsafe integer: 7 bits per byte.
+	auto const size = (to_u8(bytes[6]) << 21u) | (to_u8(bytes[7]) << 14u) | (to_u8(bytes[8]) << 7u) | to_u8(bytes[9]);
+	auto const has_footer = (to_u8(bytes[5]) & 0x10u) != 0;
+	return header_size_v + size + (has_footer ? header_size_v : 0);
+}
+
+struct Mp3Frame {
+	std::uint32_t sample_rate{};
+	std::uint32_t bitrate{};
+	std::uint32_t samples_per_frame{};
+	// offset of a Xing / Info tag from the start of the frame.
+	std::size_t xing_offset{};
+};
+
+[[nodiscard]] auto parse_mp3_frame(std::span<std::byte const> bytes) -> std::optional<Mp3Frame> {
+	if (bytes.size() < 4) { return {}; }
+	auto const b1 = to_u8(bytes[1]);
+	auto const b2 = to_u8(bytes[2]);
+	auto const b3 = to_u8(bytes[3]);
+	if (to_u8(bytes[0]) != 0xffu || (b1 & 0xe0u) != 0xe0u) { return {}; }
+
+	// version: 0 = MPEG 2.5, 2 = MPEG 2, 3 = MPEG 1. layer: 1 = III, 2 = II, 3 = I.
+	auto const version = (b1 >> 3u) & 0x3u;
+	auto const layer = (b1 >> 1u) & 0x3u;
+	auto const bitrate_index = (b2 >> 4u) & 0xfu;
+	auto const sample_rate_index = (b2 >> 2u) & 0x3u;
+	if (version == 1 || layer == 0 || bitrate_index == 0 || bitrate_index == 0xf || sample_rate_index == 3) {
+		return {};
+	}
+
+	static constexpr auto bitrates_v = std::array{
+		std::array{0, 32, 64, 96, 128, 160, 192, 224, 256, 288, 320, 352, 384, 416, 448}, // MPEG 1 layer I
+		std::array{0, 32, 48, 56, 64, 80, 96, 112, 128, 160, 192, 224, 256, 320, 384},	   // MPEG 1 layer II
+		std::array{0, 32, 40, 48, 56, 64, 80, 96, 112, 128, 160, 192, 224, 256, 320},	   // MPEG 1 layer III
+		std::array{0, 32, 48, 56, 64, 80, 96, 112, 128, 144, 160, 176, 192, 224, 256},	   // MPEG 2 layer I
+		std::array{0, 8, 16, 24, 32, 40, 48, 56, 64, 80, 96, 112, 128, 144, 160},		   // MPEG 2 layer II / III
+	};
+	static constexpr auto sample_rates_v = std::array{44100u, 48000u, 32000u};
+
+	auto const is_mpeg1 = version == 3;
+	auto const layer_index = 3 - layer; // 0 = I, 1 = II, 2 = III.
+	auto const table = is_mpeg1 ? layer_index : (layer_index == 0 ? 3u : 4u);
+	auto const is_mono = ((b3 >> 6u) & 0x3u) == 3;
+
+	auto ret = Mp3Frame{};
+	ret.bitrate = std::uint32_t(bitrates_v.at(table).at(bitrate_index)) * 1000u;
+	// MPEG 2 halves, MPEG 2.5 quarters the sample rate.
+	ret.sample_rate = sample_rates_v.at(sample_rate_index) >> (is_mpeg1 ? 0u : (version == 2 ? 1u : 2u));
+	if (layer_index == 0) {
+		ret.samples_per_frame = 384;
+	} else if (layer_index == 1 || is_mpeg1) {
+		ret.samples_per_frame = 1152;
+	} else {
+		ret.samples_per_frame = 576;
+	}
+	// header + side info.
+	if (is_mpeg1) {
+		ret.xing_offset = is_mono ? 21 : 36;
+	} else {
+		ret.xing_offset = is_mono ? 13 : 21;
+	}
+	return ret;
+}
+
+struct FrameCount {
+	std::uint64_t frames{};
+	bool estimated{};
+};
+
+// head: bytes following any ID3v2 tag, stream_size: total size of MPEG data.
+[[nodiscard]] auto get_mp3_frame_count(std::span<std::byte const> head, std::uint64_t const stream_size)
+	-> std::optional<FrameCount> {
+	// skip any junk before the first frame.
+	auto frame = std::optional<Mp3Frame>{};
+	auto offset = 0uz;
+	for (; offset + 4 <= head.size(); ++offset) {
+		frame = parse_mp3_frame(head.subspan(offset));
+		if (frame) { break; }
+	}
+	if (!frame) { return {}; }
+	head = head.subspan(offset);
+
+	// VBR: Xing / Info tag stores the number of MPEG frames.
+	static constexpr auto tag_size_v = 12uz;
+	if (head.size() >= frame->xing_offset + tag_size_v) {
+		auto const tag = head.subspan(frame->xing_offset);
+		auto const id = read_u32_be(tag);
+		static constexpr auto xing_v = 0x58696e67u; // "Xing"
+		static constexpr auto info_v = 0x496e666fu; // "Info"
+		static constexpr auto frames_flag_v = 0x1u;
+		if ((id == xing_v || id == info_v) && (read_u32_be(tag.subspan(4)) & frames_flag_v) != 0) {
+			return FrameCount{.frames = std::uint64_t(read_u32_be(tag.subspan(8))) * frame->samples_per_frame};
+		}
+	}
+
+	// VBR: VBRI tag (Fraunhofer) is always 32 bytes after the header.
+	static constexpr auto vbri_offset_v = 36uz;
+	static constexpr auto vbri_frames_offset_v = 14uz;
+	if (head.size() >= vbri_offset_v + vbri_frames_offset_v + 4) {
+		auto const tag = head.subspan(vbri_offset_v);
+		static constexpr auto vbri_v = 0x56425249u; // "VBRI"
+		if (read_u32_be(tag) == vbri_v) {
+			auto const frames = read_u32_be(tag.subspan(vbri_frames_offset_v));
+			return FrameCount{.frames = std::uint64_t(frames) * frame->samples_per_frame};
+		}
+	}
+
+	// CBR: estimate from bitrate and stream size.
+	auto const data_size = stream_size > offset ? stream_size - offset : 0;
+	auto const seconds = double(data_size) * 8.0 / double(frame->bitrate);
+	return FrameCount{.frames = std::uint64_t(seconds * double(frame->sample_rate)), .estimated = true};
+}
+
+class ProbeDecoder : public ma_decoder {
+  public:
+	ProbeDecoder(ProbeDecoder const&) = delete;
+	ProbeDecoder(ProbeDecoder&&) = delete;
+	auto operator=(ProbeDecoder const&) -> ProbeDecoder& = delete;
+	auto operator=(ProbeDecoder&&) -> ProbeDecoder& = delete;
+
+	explicit ProbeDecoder(std::span<std::byte const> bytes, Encoding const encoding) : ma_decoder({}) {
+		auto const config = make_config(encoding);
+		failed = ma_decoder_init_memory(bytes.data(), bytes.size(), &config, this) != MA_SUCCESS;
+	}
+
+	explicit ProbeDecoder(char const* path, Encoding const encoding) : ma_decoder({}) {
+		auto const config = make_config(encoding);
+		failed = ma_decoder_init_file(path, &config, this) != MA_SUCCESS;
+	}
+
+	~ProbeDecoder() {
+		if (failed) { return; }
+		ma_decoder_uninit(this);
+	}
+
+	[[nodiscard]] auto get_info(Encoding const encoding) -> std::optional<AudioInfo> {
+		if (failed) { return {}; }
+		// unknown formats fall back to trial and error: only report Opus if its (custom) backend was picked.
+		if (encoding == Encoding::Opus && !detail::is_custom_backend(*this)) { return {}; }
+		auto channels = ma_uint32{};
+		auto sample_rate = ma_uint32{};
+		auto const result = ma_decoder_get_data_format(this, nullptr, &channels, &sample_rate, nullptr, 0);
+		if (result != MA_SUCCESS || channels == 0 || sample_rate == 0) { return {}; }
+
+		auto ret = AudioInfo{
+			.encoding = encoding,
+			.channels = std::uint8_t(channels),
+			.sample_rate = std::uint32_t(sample_rate),
+		};
+		// MP3 length queries scan the whole stream, those are computed from headers by the caller instead.
+		if (encoding != Encoding::Mp3) {
+			auto frames = ma_uint64{};
+			if (ma_decoder_get_length_in_pcm_frames(this, &frames) == MA_SUCCESS) { ret.frame_count = frames; }
+		}
+		return ret;
+	}
+
+	bool failed{};
+
+  private:
+	[[nodiscard]] static auto make_config(Encoding const encoding) -> ma_decoder_config {
+		// native channels and sample rate: no conversion pipeline is required.
+		auto ret = ma_decoder_config_init(ma_format_f32, 0, 0);
+		ret.encodingFormat = detail::to_ma_encoding(encoding);
+		ret.allocationCallbacks = detail::make_allocation_callbacks();
+		detail::set_custom_backends(ret);
+		return ret;
+	}
+};
+
+template <typename F>
+auto probe_with(std::optional<Encoding> const encoding, F try_probe) -> std::optional<AudioInfo> {
+	if (encoding) { return try_probe(*encoding); }
+	for (auto const candidate : all_encodings_v) {
+		if (auto ret = try_probe(candidate)) { return ret; }
+	}
+	return {};
+}
+
+// reads the start of an MP3 file past any ID3v2 tag.
+struct Mp3FileHead {
+	explicit Mp3FileHead(char const* path) {
+		auto file = std::ifstream{path, std::ios::binary | std::ios::ate};
+		if (!file) { return; }
+		auto const file_size = std::uint64_t(file.tellg());
+		file.seekg(0);
+
+		auto id3 = std::array<std::byte, 10>{};
+		void* data = id3.data();
+		file.read(static_cast<char*>(data), std::streamsize(id3.size()));
+		auto const id3_size = file ? get_id3v2_size(id3) : 0;
+		file.clear();
+		file.seekg(std::streamoff(id3_size));
+
+		bytes.resize(std::size_t(std::min(file_size - std::min(id3_size, file_size), std::uint64_t(mp3_head_size_v))));
+		data = bytes.data();
+		file.read(static_cast<char*>(data), std::streamsize(bytes.size()));
+		bytes.resize(std::size_t(file.gcount()));
+		stream_size = file_size - std::min(id3_size, file_size);
+	}
+
+	std::vector<std::byte> bytes{};
+	std::uint64_t stream_size{};
+};
+
+void set_mp3_frame_count(AudioInfo& out, std::span<std::byte const> head, std::uint64_t const stream_size) {
+	auto const count = get_mp3_frame_count(head, stream_size);
+	if (!count) { return; }
+	out.frame_count = count->frames;
+	out.frame_count_estimated = count->estimated;
+}
+} // namespace
+} // namespace capo
+
+auto capo::probe_bytes(std::span<std::byte const> bytes, std::optional<Encoding> const encoding)
+	-> std::optional<AudioInfo> {
+	if (bytes.empty()) { return {}; }
+	return probe_with(encoding, [bytes](Encoding const candidate) -> std::optional<AudioInfo> {
+		auto decoder = ProbeDecoder{bytes, candidate};
+		auto ret = decoder.get_info(candidate);
+		if (ret && candidate == Encoding::Mp3) {
+			auto const id3_size = std::size_t(std::min(get_id3v2_size(bytes), std::uint64_t(bytes.size())));
+			auto const stream = bytes.subspan(id3_size);
+			set_mp3_frame_count(*ret, stream.subspan(0, std::min(stream.size(), mp3_head_size_v)), stream.size());
+		}
+		return ret;
+	});
+}
+
+auto capo::probe_file(char const* path, std::optional<Encoding> encoding) -> std::optional<AudioInfo> {
+	if (path == nullptr || *path == '\0') { return {}; }
+	if (!encoding) { encoding = guess_encoding(path); }
+	return probe_with(encoding, [path](Encoding const candidate) -> std::optional<AudioInfo> {
+		auto decoder = ProbeDecoder{path, candidate};
+		auto ret = decoder.get_info(candidate);
+		if (ret && candidate == Encoding::Mp3) {
+			auto const head = Mp3FileHead{path};
+			set_mp3_frame_count(*ret, head.bytes, head.stream_size);
+		}
+		return ret;
+	});
+}
+
+auto capo::probe_files(std::span<char const* const> paths, std::uint32_t const thread_count)
+	-> std::vector<std::optional<AudioInfo>> {
+	auto ret = std::vector<std::optional<AudioInfo>>(paths.size());
+	auto const probe = [&](std::size_t const i) { ret[i] = probe_file(paths[i]); };
+	detail::parallel_for(paths.size(), thread_count, probe);
+	return ret;
+}
@@ -0,0 +1,46 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+namespace capo::detail {
+// samples are tested a block at a time: the branch-free count per block vectorizes,
+// and only the block that contains the boundary is searched sample by sample.
+inline constexpr auto silence_block_v = 64uz;
+
+[[nodiscard]] inline auto count_audible(std::span<float const, silence_block_v> block, float const threshold)
+	-> std::uint32_t {
+	auto ret = std::uint32_t{};
+	for (auto const sample : block) { ret += std::abs(sample) > threshold ? 1u : 0u; }
+	return ret;
+}
+
+[[nodiscard]] inline auto is_audible(float const sample, float const threshold) -> bool {
+	return std::abs(sample) > threshold;
+}
+
+/// \brief Find the first sample with a magnitude above threshold.
+/// \returns Index of the sample, samples.size() if none.
+[[nodiscard]] inline auto find_first_audible(std::span<float const> samples, float const threshold) -> std::size_t {
+	auto offset = 0uz;
+	for (; offset + silence_block_v <= samples.size(); offset += silence_block_v) {
+		if (count_audible(samples.subspan(offset).first<silence_block_v>(), threshold) > 0) { break; }
+	}
+	auto const tail = samples.subspan(offset);
+	auto const it = std::ranges::find_if(tail, [threshold](float const s) { return is_audible(s, threshold); });
+	return offset + std::size_t(it - tail.begin());
+}
+
+/// \brief Find the last sample with a magnitude above threshold.
+/// \returns Index one past the sample, 0 if none.
+[[nodiscard]] inline auto find_last_audible(std::span<float const> samples, float const threshold) -> std::size_t {
+	auto end = samples.size();
+	for (; end >= silence_block_v; end -= silence_block_v) {
+		if (count_audible(samples.subspan(end - silence_block_v).first<silence_block_v>(), threshold) > 0) { break; }
+	}
+	while (end > 0 && !is_audible(samples[end - 1], threshold)) { --end; }
+	return end;
+}
+} // namespace capo::detail
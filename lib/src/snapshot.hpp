@@ -0,0 +1,58 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <type_traits>
+
+namespace capo::detail {
+/// \brief Single-writer value that any thread can read without locks (seqlock).
+/// Readers retry if they overlap a store (or use try_load()), the writer never waits.
+template <typename Type>
+	requires(std::is_trivially_copyable_v<Type>)
+class Snapshot {
+  public:
+	/// \brief Must only be called from one thread at a time.
+	void store(Type const& value) {
+		auto words = std::array<std::uint64_t, word_count_v>{};
+		std::memcpy(words.data(), &value, sizeof(Type));
+		auto const sequence = m_sequence.load(std::memory_order_relaxed);
+		m_sequence.store(sequence + 1, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_release);
+		for (auto i = 0uz; i < word_count_v; ++i) { m_words.at(i).store(words.at(i), std::memory_order_relaxed); }
+		m_sequence.store(sequence + 2, std::memory_order_release);
+	}
+
+	[[nodiscard]] auto load() const -> Type {
+		while (true) {
+			if (auto const ret = try_load()) { return *ret; }
+		}
+	}
+
+	/// \brief Single attempt at a load, never waits (eg for the audio thread).
+	/// \returns nullopt if a store is in progress.
+	[[nodiscard]] auto try_load() const -> std::optional<Type> {
+		auto words = std::array<std::uint64_t, word_count_v>{};
+		auto const sequence = m_sequence.load(std::memory_order_acquire);
+		if ((sequence & 1) != 0) { return {}; }
+		for (auto i = 0uz; i < word_count_v; ++i) { words.at(i) = m_words.at(i).load(std::memory_order_relaxed); }
+		std::atomic_thread_fence(std::memory_order_acquire);
+		if (m_sequence.load(std::memory_order_relaxed) != sequence) { return {}; }
+		auto ret = Type{};
+		std::memcpy(static_cast<void*>(&ret), words.data(), sizeof(Type));
+		return ret;
+	}
+
+	/// \brief Number of completed stores.
+	[[nodiscard]] auto get_version() const -> std::uint64_t {
+		return m_sequence.load(std::memory_order_acquire) / 2;
+	}
+
+  private:
+	static constexpr auto word_count_v = (sizeof(Type) + sizeof(std::uint64_t) - 1) / sizeof(std::uint64_t);
+
+	std::array<std::atomic<std::uint64_t>, word_count_v> m_words{};
+	std::atomic<std::uint64_t> m_sequence{};
+};
+} // namespace capo::detail
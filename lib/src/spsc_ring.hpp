@@ -0,0 +1,76 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <type_traits>
+
+namespace capo::detail {
+/// \brief Bounded lock-free single-producer single-consumer ring of trivially copyable values.
+/// Indices increase monotonically and are masked on access, capacity is rounded up to a power of 2.
+template <typename Type>
+	requires(std::is_trivially_copyable_v<Type>)
+class SpscRing {
+  public:
+	explicit SpscRing(std::size_t const capacity)
+		: m_data(std::make_unique_for_overwrite<Type[]>(std::bit_ceil(capacity))),
+		  m_mask(std::bit_ceil(capacity) - 1) {}
+
+	[[nodiscard]] auto get_capacity() const -> std::size_t { return m_mask + 1; }
+
+	/// \brief Number of values that can be read, safe to call from any thread.
+	[[nodiscard]] auto get_size() const -> std::size_t {
+		return std::size_t(m_write.load(std::memory_order_acquire) - m_read.load(std::memory_order_acquire));
+	}
+
+	/// \brief Number of values that can be written, must only be called from the producer thread.
+	[[nodiscard]] auto get_free() const -> std::size_t {
+		return get_capacity() - std::size_t(m_write.load(std::memory_order_relaxed) -
+											m_read.load(std::memory_order_acquire));
+	}
+
+	/// \brief Push values, must only be called from the producer thread.
+	/// \param values Values to push, must fit (see get_free()).
+	void write(std::span<Type const> values) {
+		auto const write = m_write.load(std::memory_order_relaxed);
+		for_each_chunk(values, write, [this](std::size_t const index, std::span<Type const> in) {
+			std::ranges::copy(in, m_data.get() + index);
+		});
+		m_write.store(write + values.size(), std::memory_order_release);
+	}
+
+	/// \brief Pop values, must only be called from the consumer thread.
+	/// \param out Values to pop into, size must not exceed get_size().
+	void read(std::span<Type> out) {
+		auto const read = m_read.load(std::memory_order_relaxed);
+		for_each_chunk(out, read, [this](std::size_t const index, std::span<Type> chunk) {
+			std::copy_n(m_data.get() + index, chunk.size(), chunk.begin());
+		});
+		m_read.store(read + out.size(), std::memory_order_release);
+	}
+
+	/// \brief Discard all readable values, must only be called from the consumer thread.
+	void clear() { m_read.store(m_write.load(std::memory_order_acquire), std::memory_order_release); }
+
+  private:
+	// invokes func for the (at most two) contiguous chunks of the ring covering [position, position + size).
+	template <typename T, typename F>
+	void for_each_chunk(std::span<T> values, std::uint64_t const position, F func) const {
+		auto const index = std::size_t(position) & m_mask;
+		auto const first = std::min(values.size(), get_capacity() - index);
+		func(index, values.subspan(0, first));
+		if (first < values.size()) { func(0, values.subspan(first)); }
+	}
+
+	// avoid false sharing between the producer and the consumer.
+	static constexpr auto cache_line_v = 64uz;
+
+	std::unique_ptr<Type[]> m_data{};
+	std::size_t m_mask{};
+	alignas(cache_line_v) std::atomic<std::uint64_t> m_write{};
+	alignas(cache_line_v) std::atomic<std::uint64_t> m_read{};
+};
+} // namespace capo::detail
@@ -0,0 +1,222 @@
+#include <capo/trace.hpp>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <format>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <vector>
+#include "trace.hpp"
+
+namespace capo {
+namespace {
+#if defined(CAPO_TRACE)
+struct Record {
+	char const* name{};
+	std::uint64_t start{};
+	std::uint64_t end{};
+	std::uint32_t thread{};
+};
+
+// single producer (the owning thread), any thread can collect.
+// a collector discards events that the producer may have overwritten while they were being copied.
+class ThreadRing {
+  public:
+	static constexpr auto capacity_v = 8192uz;
+
+	explicit ThreadRing(std::uint32_t const thread) : m_thread(thread) {}
+
+	void push(char const* name, std::uint64_t const start, std::uint64_t const end) {
+		auto const index = m_written.load(std::memory_order_relaxed);
+		auto& event = m_events.at(index % capacity_v);
+		event.name.store(name, std::memory_order_relaxed);
+		event.start.store(start, std::memory_order_relaxed);
+		event.end.store(end, std::memory_order_relaxed);
+		m_written.store(index + 1, std::memory_order_release);
+	}
+
+	void collect(std::vector<Record>& out) const {
+		auto const written = m_written.load(std::memory_order_acquire);
+		auto const first = std::max(written > capacity_v ? written - capacity_v : 0, m_cleared.load());
+		auto const offset = out.size();
+		for (auto index = first; index < written; ++index) {
+			auto const& event = m_events.at(index % capacity_v);
+			out.push_back(Record{.name = event.name.load(std::memory_order_relaxed),
+								 .start = event.start.load(std::memory_order_relaxed),
+								 .end = event.end.load(std::memory_order_relaxed),
+								 .thread = m_thread});
+		}
+		std::atomic_thread_fence(std::memory_order_acquire);
+		// the producer may be writing the slot of index `now`, which evicts index `now - capacity`.
+		auto const now = m_written.load(std::memory_order_relaxed);
+		auto const valid = now >= capacity_v ? now - capacity_v + 1 : 0;
+		if (valid <= first) { return; }
+		auto const stale = std::min(std::size_t(valid - first), out.size() - offset);
+		out.erase(out.begin() + std::ptrdiff_t(offset), out.begin() + std::ptrdiff_t(offset + stale));
+	}
+
+	void clear() { m_cleared.store(m_written.load()); }
+
+  private:
+	struct Event {
+		std::atomic<char const*> name{};
+		std::atomic<std::uint64_t> start{};
+		std::atomic<std::uint64_t> end{};
+	};
+
+	std::array<Event, capacity_v> m_events{};
+	std::atomic<std::uint64_t> m_written{};
+	std::atomic<std::uint64_t> m_cleared{};
+	std::uint32_t m_thread{};
+};
+
+// rings outlive their threads, so that spans of exited threads can still be exported.
+// the ring of an exited thread is reused by the next new thread (spans continue on its track),
+// so the number of rings is bounded by the peak number of concurrent threads.
+struct Registry {
+	std::atomic_bool enabled{true};
+	std::mutex mutex{};
+	std::vector<std::shared_ptr<ThreadRing>> rings{};
+	std::vector<ThreadRing*> free_rings{};
+	std::chrono::steady_clock::time_point epoch{std::chrono::steady_clock::now()};
+
+	static auto self() -> Registry& {
+		static auto ret = Registry{};
+		return ret;
+	}
+
+	auto now() const -> std::uint64_t {
+		auto const elapsed = std::chrono::steady_clock::now() - epoch;
+		return std::uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+	}
+
+	auto get_ring() -> ThreadRing& {
+		thread_local auto const lease = Lease{acquire_ring()};
+		return *lease.ring;
+	}
+
+  private:
+	// returns a thread's ring to the registry when the thread exits.
+	struct Lease {
+		Lease(Lease const&) = delete;
+		Lease(Lease&&) = delete;
+		auto operator=(Lease const&) -> Lease& = delete;
+		auto operator=(Lease&&) -> Lease& = delete;
+
+		explicit Lease(ThreadRing* ring) : ring(ring) {}
+		~Lease() { self().release_ring(ring); }
+
+		ThreadRing* ring{};
+	};
+
+	auto acquire_ring() -> ThreadRing* {
+		auto lock = std::scoped_lock{mutex};
+		if (!free_rings.empty()) {
+			auto* ret = free_rings.back();
+			free_rings.pop_back();
+			return ret;
+		}
+		return rings.emplace_back(std::make_shared<ThreadRing>(std::uint32_t(rings.size() + 1))).get();
+	}
+
+	void release_ring(ThreadRing* ring) {
+		auto lock = std::scoped_lock{mutex};
+		free_rings.push_back(ring);
+	}
+};
+
+void append_escaped(std::string& out, std::string_view const text) {
+	for (auto const c : text) {
+		if (c == '"' || c == '\\') { out.push_back('\\'); }
+		out.push_back(c);
+	}
+}
+#endif
+} // namespace
+
+#if defined(CAPO_TRACE)
+detail::TraceSpan::TraceSpan(char const* name) {
+	auto& registry = Registry::self();
+	if (!registry.enabled.load(std::memory_order_relaxed)) { return; }
+	m_name = name;
+	m_start = registry.now();
+}
+
+detail::TraceSpan::~TraceSpan() {
+	if (m_name == nullptr) { return; }
+	auto& registry = Registry::self();
+	registry.get_ring().push(m_name, m_start, registry.now());
+}
+#endif
+} // namespace capo
+
+auto capo::is_trace_available() -> bool {
+#if defined(CAPO_TRACE)
+	return true;
+#else
+	return false;
+#endif
+}
+
+auto capo::is_trace_enabled() -> bool {
+#if defined(CAPO_TRACE)
+	return Registry::self().enabled.load();
+#else
+	return false;
+#endif
+}
+
+void capo::set_trace_enabled([[maybe_unused]] bool const enabled) {
+#if defined(CAPO_TRACE)
+	Registry::self().enabled.store(enabled);
+#endif
+}
+
+void capo::clear_trace() {
+#if defined(CAPO_TRACE)
+	auto& registry = Registry::self();
+	auto lock = std::scoped_lock{registry.mutex};
+	for (auto const& ring : registry.rings) { ring->clear(); }
+#endif
+}
+
+auto capo::get_trace_json() -> std::string {
+	auto ret = std::string{R"({"displayTimeUnit":"ms","traceEvents":[)"};
+#if defined(CAPO_TRACE)
+	auto records = std::vector<Record>{};
+	{
+		auto& registry = Registry::self();
+		auto lock = std::scoped_lock{registry.mutex};
+		for (auto const& ring : registry.rings) { ring->collect(records); }
+	}
+	std::ranges::sort(records, {}, &Record::start);
+	auto first = true;
+	for (auto const& record : records) {
+		if (!first) { ret.push_back(','); }
+		first = false;
+		ret.append(R"({"name":")");
+		append_escaped(ret, record.name);
+		// complete events, timestamps are in microseconds.
+		auto const start = double(record.start) / 1000.0;
+		auto const duration = double(record.end - record.start) / 1000.0;
+		auto out = std::back_inserter(ret);
+		std::format_to(out, R"(","cat":"capo","ph":"X","ts":{:.3f},"dur":{:.3f},)", start, duration);
+		std::format_to(out, R"("pid":1,"tid":{}}})", record.thread);
+	}
+#endif
+	ret.append("]}");
+	return ret;
+}
+
+auto capo::write_trace_file(char const* path) -> bool {
+	auto file = std::ofstream{path, std::ios::binary | std::ios::trunc};
+	if (!file) { return false; }
+	auto const json = get_trace_json();
+	file.write(json.data(), std::streamsize(json.size()));
+	return bool(file);
+}
@@ -0,0 +1,31 @@
+#pragma once
+#include <cstdint>
+
+namespace capo::detail {
+/// \brief Records a span (named scope) on the current thread, if tracing is enabled.
+/// Use via CAPO_TRACE_SCOPE(), which compiles to nothing without CAPO_TRACE.
+/// name must be a string literal (only the pointer is stored).
+/// A thread's first span allocates its ring, all others are wait-free.
+class TraceSpan {
+  public:
+	TraceSpan(TraceSpan const&) = delete;
+	TraceSpan(TraceSpan&&) = delete;
+	auto operator=(TraceSpan const&) -> TraceSpan& = delete;
+	auto operator=(TraceSpan&&) -> TraceSpan& = delete;
+
+	explicit TraceSpan(char const* name);
+	~TraceSpan();
+
+  private:
+	char const* m_name{};
+	std::uint64_t m_start{};
+};
+} // namespace capo::detail
+
+#if defined(CAPO_TRACE)
+#define CAPO_TRACE_CONCAT_IMPL(a, b) a##b
+#define CAPO_TRACE_CONCAT(a, b) CAPO_TRACE_CONCAT_IMPL(a, b)
+#define CAPO_TRACE_SCOPE(name) ::capo::detail::TraceSpan const CAPO_TRACE_CONCAT(capo_trace_span_, __LINE__){name}
+#else
+#define CAPO_TRACE_SCOPE(name) static_cast<void>(0)
+#endif
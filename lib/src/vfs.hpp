@@ -0,0 +1,22 @@
+#pragma once
+#include <miniaudio.h>
+#include <capo/file_system.hpp>
+#include <vector>
+
+namespace capo::detail {
+/// \brief Read the rest of a file.
+[[nodiscard]] auto read_all(IFile& file) -> std::vector<std::byte>;
+
+/// \brief Adapts an IFileSystem to miniaudio's ma_vfs.
+/// Pass a pointer to this as ma_vfs*: miniaudio reads the callbacks from the base.
+class Vfs : public ma_vfs_callbacks {
+  public:
+	explicit Vfs(IFileSystem& file_system);
+
+	[[nodiscard]] auto get_file_system() const -> IFileSystem& { return *m_file_system; }
+	[[nodiscard]] auto as_ma_vfs() -> ma_vfs* { return static_cast<ma_vfs_callbacks*>(this); }
+
+  private:
+	IFileSystem* m_file_system{};
+};
+} // namespace capo::detail
@@ -0,0 +1,185 @@
+#include <miniaudio.h>
+#include <capo/wav_writer.hpp>
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <fstream>
+#include <vector>
+
+namespace capo {
+namespace {
+constexpr auto to_ma_format(WavFormat const format) -> ma_format {
+	switch (format) {
+	case WavFormat::S16: return ma_format_s16;
+	default: return ma_format_f32;
+	}
+}
+
+// stages encoded bytes and writes them to disk in large chunks.
+class FileSink {
+  public:
+	static constexpr auto capacity_v = 1uz /*MiB*/ * 1024uz /*KiB*/ * 1024uz /*B*/;
+
+	explicit FileSink(char const* path) : m_file(path, std::ios::binary | std::ios::trunc) {
+		m_buffer.reserve(capacity_v);
+	}
+
+	[[nodiscard]] auto is_open() const -> bool { return m_file.is_open(); }
+
+	auto write(void const* data, std::size_t const size) -> bool {
+		auto const bytes = std::span{static_cast<char const*>(data), size};
+		if (m_buffer.size() + bytes.size() > capacity_v && !flush()) { return false; }
+		if (bytes.size() >= capacity_v) {
+			// large write: bypass staging.
+			m_file.write(bytes.data(), std::streamsize(bytes.size()));
+			return m_file.good();
+		}
+		m_buffer.insert(m_buffer.end(), bytes.begin(), bytes.end());
+		return true;
+	}
+
+	auto seek(std::int64_t const offset, ma_seek_origin const origin) -> bool {
+		// only the header is patched via seeks, at the end: flush first so positions are consistent.
+		if (!flush()) { return false; }
+		auto const dir = [origin] {
+			switch (origin) {
+			case ma_seek_origin_current: return std::ios::cur;
+			case ma_seek_origin_end: return std::ios::end;
+			default: return std::ios::beg;
+			}
+		}();
+		m_file.seekp(offset, dir);
+		return m_file.good();
+	}
+
+	auto flush() -> bool {
+		if (m_buffer.empty()) { return m_file.good(); }
+		m_file.write(m_buffer.data(), std::streamsize(m_buffer.size()));
+		m_buffer.clear();
+		return m_file.good();
+	}
+
+  private:
+	std::ofstream m_file;
+	std::vector<char> m_buffer{};
+};
+
+class WavWriter : public IWavWriter {
+  public:
+	WavWriter(WavWriter const&) = delete;
+	WavWriter(WavWriter&&) = delete;
+	auto operator=(WavWriter const&) -> WavWriter& = delete;
+	auto operator=(WavWriter&&) -> WavWriter& = delete;
+
+	explicit WavWriter(char const* path, std::uint8_t const channels, std::uint32_t const sample_rate,
+					   WavFormat const format)
+		: m_sink(path), m_channels(channels), m_sample_rate(sample_rate), m_format(format) {
+		if (!m_sink.is_open()) { return; }
+		auto const config = ma_encoder_config_init(ma_encoding_format_wav, to_ma_format(format), channels, sample_rate);
+		if (ma_encoder_init(&on_write, &on_seek, &m_sink, &config, &m_encoder) != MA_SUCCESS) { return; }
+		m_active = true;
+	}
+
+	~WavWriter() override { finish(); }
+
+	[[nodiscard]] auto is_active() const -> bool { return m_active; }
+
+	[[nodiscard]] auto get_channels() const -> std::uint8_t final { return m_channels; }
+	[[nodiscard]] auto get_sample_rate() const -> std::uint32_t final { return m_sample_rate; }
+	[[nodiscard]] auto get_format() const -> WavFormat final { return m_format; }
+	[[nodiscard]] auto get_frames_written() const -> std::uint64_t final { return m_frames_written; }
+
+	auto write_samples(std::span<float const> samples) -> bool final {
+		if (!m_active) { return false; }
+		assert(samples.size() % m_channels == 0);
+		if (m_format == WavFormat::F32) { return write_frames(samples.data(), samples.size() / m_channels); }
+
+		// convert in chunks, with dithering.
+		static constexpr auto chunk_size_v = 16uz /*KiB*/ * 1024uz /*B*/ / sizeof(std::int16_t);
+		m_scratch.resize(chunk_size_v - (chunk_size_v % m_channels));
+		while (!samples.empty()) {
+			auto const count = std::min(samples.size(), m_scratch.size());
+			ma_pcm_f32_to_s16(m_scratch.data(), samples.data(), count, ma_dither_mode_triangle);
+			if (!write_frames(m_scratch.data(), count / m_channels)) { return false; }
+			samples = samples.subspan(count);
+		}
+		return true;
+	}
+
+	auto finish() -> bool final {
+		if (!m_active) { return !m_failed; }
+		m_active = false;
+		// the encoder seeks back and patches the RIFF / data chunk sizes on uninit.
+		ma_encoder_uninit(&m_encoder);
+		if (!m_sink.flush()) { m_failed = true; }
+		return !m_failed;
+	}
+
+  private:
+	auto write_frames(void const* data, std::size_t const frames) -> bool {
+		auto written = ma_uint64{};
+		if (ma_encoder_write_pcm_frames(&m_encoder, data, frames, &written) != MA_SUCCESS || written != frames) {
+			m_failed = true;
+			return false;
+		}
+		m_frames_written += written;
+		return true;
+	}
+
+	static auto on_write(ma_encoder* encoder, void const* data, std::size_t size, std::size_t* written) -> ma_result {
+		auto& sink = *static_cast<FileSink*>(encoder->pUserData);
+		if (!sink.write(data, size)) {
+			*written = 0;
+			return MA_IO_ERROR;
+		}
+		*written = size;
+		return MA_SUCCESS;
+	}
+
+	static auto on_seek(ma_encoder* encoder, ma_int64 offset, ma_seek_origin origin) -> ma_result {
+		auto& sink = *static_cast<FileSink*>(encoder->pUserData);
+		return sink.seek(offset, origin) ? MA_SUCCESS : MA_IO_ERROR;
+	}
+
+	FileSink m_sink;
+	ma_encoder m_encoder{};
+	std::vector<std::int16_t> m_scratch{};
+	std::uint64_t m_frames_written{};
+	std::uint8_t m_channels{};
+	std::uint32_t m_sample_rate{};
+	WavFormat m_format{};
+	bool m_active{};
+	bool m_failed{};
+};
+} // namespace
+} // namespace capo
+
+auto capo::create_wav_writer(char const* path, std::uint8_t const channels, std::uint32_t const sample_rate,
+							 WavFormat const format) -> std::unique_ptr<IWavWriter> {
+	if (path == nullptr || *path == '\0' || channels == 0 || sample_rate == 0) { return {}; }
+	auto ret = std::make_unique<WavWriter>(path, channels, sample_rate, format);
+	if (!ret->is_active()) { return {}; }
+	return ret;
+}
+
+auto capo::write_wav_file(Buffer const& buffer, char const* path, WavFormat const format) -> bool {
+	if (!buffer.is_loaded()) { return false; }
+	auto writer = create_wav_writer(path, buffer.get_channels(), Buffer::sample_rate_v, format);
+	if (!writer) { return false; }
+	return writer->write_samples(buffer.get_samples()) && writer->finish();
+}
+
+auto capo::write_wav_file(IStream& stream, char const* path, WavFormat const format) -> bool {
+	auto const channels = stream.get_channels();
+	auto writer = create_wav_writer(path, channels, stream.get_sample_rate(), format);
+	if (!writer) { return false; }
+	static constexpr auto buffer_size_v = 64uz /*KiB*/ * 1024uz /*B*/ / sizeof(float);
+	auto buffer = std::vector<float>(buffer_size_v - (buffer_size_v % channels));
+	while (true) {
+		auto const read = stream.read_samples(buffer);
+		if (read == 0) { break; }
+		// only write whole frames.
+		if (!writer->write_samples(std::span{buffer}.subspan(0, read - (read % channels)))) { return false; }
+	}
+	return writer->finish();
+}